@@ -6,6 +6,9 @@
 #include <memory>
 #include <chrono>
 
+#include "../common/fast_io.h"
+#include "../common/indexed_heap.h"
+
 
 class steady_timer {
  public:
@@ -28,215 +31,91 @@ class steady_timer {
 };
 
 
-template <class T, class Compare = std::less<T>>
-class Heap {
- public:
-  using IndexChangeObserver = std::function<void(const T& element, int new_element_index)>;
-
-  static constexpr int invalid_index = -1;
-
-  Heap(Compare compare = Compare(),
-       IndexChangeObserver index_change_observer = IndexChangeObserver()) {
-    compare_ = compare;
-    index_change_observer_ = index_change_observer;
-  }
-
-  int size() const {
-    return elements_.size();
-  }
-
-  bool empty() const {
-    return elements_.empty();
-  }
-
-  int push(const T& value) {
-    elements_.push_back(value);
-    NotifyIndexChange(value, this->size() - 1);
-    return SiftUp(this->size() - 1);
-  }
-
-  void erase(int index) {
-    elements_[index] = elements_[0];
-    NotifyIndexChange(elements_[index], index);
-    SiftUp(index);
-    pop();
-  }
-
-  const T& top() const {
-    return elements_[0];
-  }
-
-  void pop() {
-    NotifyIndexChange(elements_[0], invalid_index);
-    if (this->size() > 1) {
-      elements_[0] = elements_[this->size() - 1];
-      NotifyIndexChange(elements_[0], 0);
-    }
-    elements_.pop_back();
-    SiftDown(0);
-  }
-
- private:
-  IndexChangeObserver index_change_observer_;
-  Compare compare_;
-  std::vector<T> elements_;
-
-  int Parent(int index) const {
-    if (index != 0) {
-      return (index - 1) / 2;
-    }
-    return invalid_index;
-  }
-
-  int LeftSon(int index) const {
-    if (2 * index + 1 < this->size()) {
-      return 2 * index + 1;
-    }
-    return invalid_index;
-  }
-
-  int RightSon(int index) const {
-    if (2 * index + 2 < size()) {
-      return 2 * index + 2;
-    }
-    return invalid_index;
-  }
-
-  bool CompareElements(int first_index, int second_index) const {
-    return compare_(elements_[first_index], elements_[second_index]);
-  }
-
-  void NotifyIndexChange(const T& element, int new_element_index) {
-    index_change_observer_(element, new_element_index);
-  }
-
-  void SwapElements(int first_index, int second_index) {
-    NotifyIndexChange(elements_[first_index], second_index);
-    NotifyIndexChange(elements_[second_index], first_index);
-    std::swap(elements_[first_index], elements_[second_index]);
-  }
-
-  int SiftUp(int index) {
-    bool flag = true;
-    while (flag) {
-      int parent = Parent(index);
-      if (parent == invalid_index) {
-        break;
-      }
-      if (CompareElements(index, parent)) {
-        SwapElements(index, parent);
-      }
-      index = parent;
-    }
-    return index;
-  }
-
-  void SiftDown(int index) {
-    bool flag = true;
-    while (flag) {
-      int left_index = LeftSon(index);
-      int right_index = RightSon(index);
-      int swap_index;
-      if (left_index == invalid_index && right_index == invalid_index) {
-        break;
-      }
-      if (left_index == invalid_index && right_index != invalid_index) {
-        swap_index = right_index;
-      }
-      if (left_index != invalid_index && right_index == invalid_index) {
-        swap_index = left_index;
-      }
-      if (left_index != invalid_index && right_index != invalid_index) {
-        if (CompareElements(left_index, right_index)) {
-          swap_index = left_index;
-        } else {
-          swap_index = right_index;
-        }
-      }
-      if (!CompareElements(index, swap_index)) {
-        SwapElements(index, swap_index);
-      }
-      index = swap_index;
-    }
-  }
-};
-
 struct HeapElement {
   int value;
   bool min_heap;
   bool max_heap;
-  int heap_index;
+  size_t heap_index;
 };
 
 using Iterator = std::vector<HeapElement>::iterator;
 
+/*
+ * IndexedHeap держит на вершине наибольший относительно компаратора
+ * элемент, поэтому для кучи минимумов компаратор сравнивает значения
+ * «наоборот». При равных значениях выше стоит более левый элемент.
+ */
+
 struct MinHeapCompare {
   bool operator() (Iterator first, Iterator second) const {
     if ((*first).value == (*second).value) {
-      return first <= second;
+      return first > second;
     }
-    return (*first).value < (*second).value;
+    return (*first).value > (*second).value;
   }
 };
 
 struct MaxHeapCompare {
   bool operator() (Iterator first, Iterator second) const {
     if ((*first).value == (*second).value)
-      return first <= second;
-    return (*first).value > (*second).value;
+      return first > second;
+    return (*first).value < (*second).value;
   }
 };
 
 struct ValueIndexObserver {
-  void operator() (Iterator element_iterator, int new_index) const {
+  void operator() (Iterator element_iterator, size_t new_index) const {
     (*element_iterator).heap_index = new_index;
   }
 };
 
+using MinHeap = IndexedHeap<Iterator, MinHeapCompare, ValueIndexObserver, 4>;
+using MaxHeap = IndexedHeap<Iterator, MaxHeapCompare, ValueIndexObserver, 4>;
+
 std::vector<int> GetKthStatistics(const std::vector<int> &input_vector,
-                                  const std::string &commands, int k_order) {
+                                  const std::string &commands, size_t k_order) {
   std::vector<int> k_order_statistics;
   std::vector<HeapElement> elements;
-  auto min_heap =  Heap<Iterator, MinHeapCompare>(MinHeapCompare(), ValueIndexObserver());
-  auto max_heap =  Heap<Iterator, MaxHeapCompare>(MaxHeapCompare(), ValueIndexObserver());
-  for (int i = 0; i < input_vector.size(); ++i)
+  MinHeap min_heap;
+  MaxHeap max_heap;
+  for (size_t i = 0; i < input_vector.size(); ++i)
     elements.emplace_back(HeapElement({input_vector[i], false, false,
-                                       Heap<Iterator>::invalid_index}));
+                                       MinHeap::kNullIndex}));
   Iterator left = elements.begin();
   Iterator right = elements.begin();
 
   (*right).max_heap = true;
-  max_heap.push(right);
-  for (int command_number = 0; command_number < commands.length(); ++command_number) {
+  max_heap.Push(right);
+  for (size_t command_number = 0; command_number < commands.length(); ++command_number) {
     if (commands[command_number] == 'R') {
       right++;
       if (max_heap.size() < k_order) {
         (*right).max_heap = true;
-        max_heap.push(right);
+        max_heap.Push(right);
       } else if ((*right).value < (*max_heap.top()).value) {
         auto value = max_heap.top();
-        max_heap.pop();
+        max_heap.Pop();
         (*value).max_heap = false;
         (*value).min_heap = true;
-        min_heap.push(value);
+        min_heap.Push(value);
         (*right).max_heap = true;
-        max_heap.push(right);
+        max_heap.Push(right);
       } else {
         (*right).max_heap = false;
         (*right).min_heap = true;
-        min_heap.push(right);
+        min_heap.Push(right);
       }
     } else {
       if ((*left).min_heap) {
-        min_heap.erase((*left).heap_index);
+        min_heap.Erase((*left).heap_index);
       } else {
-        max_heap.erase((*left).heap_index);
+        max_heap.Erase((*left).heap_index);
         if (min_heap.size() > 0) {
           auto value = min_heap.top();
-          min_heap.pop();
+          min_heap.Pop();
           (*value).max_heap = true;
           (*value).min_heap = false;
-          max_heap.push(value);
+          max_heap.Push(value);
         }
       }
       left++;
@@ -251,34 +130,35 @@ std::vector<int> GetKthStatistics(const std::vector<int> &input_vector,
   return k_order_statistics;
 }
 
-std::vector<int> read_elements(int size) {
+std::vector<int> read_elements(FastReader &reader, int size) {
   std::vector<int> elements;
+  elements.reserve(size);
   for (int i = 0; i < size; ++i) {
-    int cur_element;
-    std::cin >> cur_element;
-    elements.push_back(cur_element);
+    elements.push_back(reader.ReadInteger());
   }
   return elements;
 }
 
-std::string read_commands() {
-  std::string commands;
-  std::cin >> commands;
-  return commands;
+std::string read_commands(FastReader &reader) {
+  return reader.ReadToken();
 }
 
-void print_answer(const std::vector<int> &answer) {
+void print_answer(const std::vector<int> &answer, FastWriter &writer) {
   for (auto &element: answer) {
-    std::cout << element << "\n";
+    writer.WriteInteger(element);
+    writer.WriteChar('\n');
   }
 }
 
 int main() {
-  int number_of_elements, number_of_commands, k_order;
-  std::cin >> number_of_elements >> number_of_commands >> k_order;
-  auto elements = read_elements(number_of_elements);
-  auto commands = read_commands();
+  FastReader reader;
+  FastWriter writer;
+  int number_of_elements = reader.ReadInteger();
+  reader.ReadInteger();  /* число команд: оно равно длине строки команд */
+  size_t k_order = reader.ReadInteger();
+  auto elements = read_elements(reader, number_of_elements);
+  auto commands = read_commands(reader);
   auto answer = GetKthStatistics(elements, commands, k_order);
-  print_answer(answer);
+  print_answer(answer, writer);
   return 0;
 }
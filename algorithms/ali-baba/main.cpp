@@ -2,6 +2,8 @@
 #include <vector>
 #include <algorithm>
 
+#include "../common/fast_io.h"
+
 constexpr int MAX_VALUE = 1000000;
 
 struct Coin {
@@ -19,13 +21,13 @@ bool operator()(const Coin& first_coin, const Coin& second_coin) {
   }
 };
 
-std::vector<Coin> read_coins() {
-  int size;
+std::vector<Coin> read_coins(FastReader& reader) {
   std::vector<Coin> coins;
-  std::cin >> size;
+  int size = reader.ReadInteger();
+  coins.reserve(size);
   for (int i = 0; i < size; ++i) {
-      int cur_position, cur_time;
-      std::cin >> cur_position >> cur_time;
+      int cur_position = reader.ReadInteger();
+      int cur_time = reader.ReadInteger();
       coins.emplace_back(Coin(cur_position, cur_time));
   }
   return coins;
@@ -100,14 +102,17 @@ void erase_duplicates(std::vector<Coin>& coins) {
 }
 
 int main() {
-  auto coins = read_coins();
+  FastReader reader;
+  FastWriter writer;
+  auto coins = read_coins(reader);
   std::sort(coins.begin(), coins.end(), CoinComparartor());
   erase_duplicates(coins);
   int best_time = get_best_time(coins);
   if (best_time == -1) {
-    std::cout << "No solution" << std::endl;
+    writer.WriteString("No solution\n");
   } else {
-    std::cout << best_time << std::endl;
+    writer.WriteInteger(best_time);
+    writer.WriteChar('\n');
   }
   return 0;
 }
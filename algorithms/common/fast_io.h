@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+
+/*
+ * Общий для всех задач быстрый ввод-вывод. FastReader читает вход
+ * крупными блоками через read(2) в собственный буфер фиксированного
+ * размера и разбирает числа и символы прямо из него, минуя iostream.
+ * FastWriter копит вывод в буфере и сбрасывает его одним write(2),
+ * когда буфер заполнен, а также при Flush и в деструкторе.
+ */
+
+constexpr size_t FAST_IO_BUFFER_SIZE = 1 << 16;
+
+class FastReader {
+ public:
+  explicit FastReader(int descriptor = STDIN_FILENO):
+      descriptor_(descriptor), begin_(0), end_(0)
+  {}
+
+  FastReader(const FastReader&) = delete;
+  FastReader& operator=(const FastReader&) = delete;
+
+  /*
+   * Пропускает пробельные символы. Возвращает false, если вход закончился.
+   */
+  bool SkipSpaces() {
+    while (true) {
+      while (begin_ < end_ && static_cast<unsigned char>(buffer_[begin_]) <= ' ') {
+        ++begin_;
+      }
+      if (begin_ < end_) {
+        return true;
+      }
+      if (!Refill()) {
+        return false;
+      }
+    }
+  }
+
+  template <class Integer = int>
+  Integer ReadInteger() {
+    SkipSpaces();
+    bool negative = false;
+    if (Peek() == '-' || Peek() == '+') {
+      negative = Peek() == '-';
+      ++begin_;
+    }
+    typename std::make_unsigned<Integer>::type value = 0;
+    while (true) {
+      if (begin_ == end_ && !Refill()) {
+        break;
+      }
+      unsigned digit = static_cast<unsigned char>(buffer_[begin_]) - '0';
+      if (digit > 9) {
+        break;
+      }
+      value = value * 10 + digit;
+      ++begin_;
+    }
+    return static_cast<Integer>(negative ? 0 - value : value);
+  }
+
+  /*
+   * Возвращает очередной непробельный символ или '\0' в конце входа.
+   */
+  char ReadChar() {
+    if (!SkipSpaces()) {
+      return '\0';
+    }
+    return buffer_[begin_++];
+  }
+
+  std::string ReadToken() {
+    std::string token;
+    SkipSpaces();
+    while (begin_ < end_ || Refill()) {
+      size_t token_end = begin_;
+      while (token_end < end_ && static_cast<unsigned char>(buffer_[token_end]) > ' ') {
+        ++token_end;
+      }
+      token.append(buffer_ + begin_, token_end - begin_);
+      begin_ = token_end;
+      if (begin_ < end_) {
+        break;
+      }
+    }
+    return token;
+  }
+
+ private:
+  int descriptor_;
+  size_t begin_;
+  size_t end_;
+  char buffer_[FAST_IO_BUFFER_SIZE];
+
+  char Peek() {
+    if (begin_ == end_ && !Refill()) {
+      return '\0';
+    }
+    return buffer_[begin_];
+  }
+
+  bool Refill() {
+    begin_ = 0;
+    end_ = 0;
+    while (true) {
+      auto bytes_read = read(descriptor_, buffer_, FAST_IO_BUFFER_SIZE);
+      if (bytes_read > 0) {
+        end_ = bytes_read;
+        return true;
+      }
+      if (bytes_read == 0 || errno != EINTR) {
+        return false;
+      }
+    }
+  }
+};
+
+class FastWriter {
+ public:
+  explicit FastWriter(int descriptor = STDOUT_FILENO):
+      descriptor_(descriptor), size_(0)
+  {}
+
+  FastWriter(const FastWriter&) = delete;
+  FastWriter& operator=(const FastWriter&) = delete;
+
+  ~FastWriter() {
+    Flush();
+  }
+
+  template <class Integer>
+  void WriteInteger(Integer value) {
+    Reserve(24);
+    typename std::make_unsigned<Integer>::type magnitude = value;
+    if (value < 0) {
+      buffer_[size_++] = '-';
+      magnitude = 0 - magnitude;
+    }
+    char digits[24];
+    size_t digits_count = 0;
+    do {
+      digits[digits_count++] = '0' + magnitude % 10;
+      magnitude /= 10;
+    } while (magnitude != 0);
+    while (digits_count > 0) {
+      buffer_[size_++] = digits[--digits_count];
+    }
+  }
+
+  void WriteChar(char symbol) {
+    Reserve(1);
+    buffer_[size_++] = symbol;
+  }
+
+  void WriteString(const char* string, size_t length) {
+    while (length > 0) {
+      Reserve(1);
+      size_t chunk = std::min(length, FAST_IO_BUFFER_SIZE - size_);
+      std::memcpy(buffer_ + size_, string, chunk);
+      size_ += chunk;
+      string += chunk;
+      length -= chunk;
+    }
+  }
+
+  void WriteString(const char* string) {
+    WriteString(string, std::strlen(string));
+  }
+
+  void WriteString(const std::string& string) {
+    WriteString(string.data(), string.size());
+  }
+
+  /*
+   * Форматированный вывод в духе printf, для чисел с плавающей точкой.
+   */
+  template <class... Arguments>
+  void WriteFormatted(const char* format, Arguments... arguments) {
+    char formatted[128];
+    int length = std::snprintf(formatted, sizeof(formatted), format, arguments...);
+    WriteString(formatted, std::min<size_t>(length, sizeof(formatted) - 1));
+  }
+
+  void Flush() {
+    size_t written = 0;
+    while (written < size_) {
+      auto bytes_written = write(descriptor_, buffer_ + written, size_ - written);
+      if (bytes_written < 0 && errno == EINTR) {
+        continue;
+      }
+      if (bytes_written <= 0) {
+        break;
+      }
+      written += bytes_written;
+    }
+    size_ = 0;
+  }
+
+ private:
+  int descriptor_;
+  size_t size_;
+  char buffer_[FAST_IO_BUFFER_SIZE];
+
+  void Reserve(size_t length) {
+    if (size_ + length > FAST_IO_BUFFER_SIZE) {
+      Flush();
+    }
+  }
+};
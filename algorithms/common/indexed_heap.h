@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/*
+ * Куча с возможностью удаления элемента по индексу. На вершине лежит
+ * наибольший относительно Compare элемент, как в std::priority_queue.
+ *
+ * Об изменении позиции элемента куча сообщает наблюдателю IndexObserver,
+ * который является параметром шаблона, а не std::function: вызов
+ * подставляется на месте, а NoIndexObserver не стоит ничего. Просеивание
+ * двигает «дырку» вместо обменов, поэтому каждый сдвинутый элемент
+ * записывается и сообщается наблюдателю ровно один раз. Arity задаёт
+ * число сыновей вершины: 4 и 8 укорачивают путь просеивания вниз и
+ * кладут всех сыновей в одну-две кеш-линии.
+ */
+
+struct NoIndexObserver {
+  template <class T>
+  void operator()(const T& /* element */, size_t /* new_element_index */) const {
+  }
+};
+
+template <class T, class Compare = std::less<T>, class IndexObserver = NoIndexObserver,
+          size_t Arity = 2>
+class IndexedHeap {
+ public:
+  static_assert(Arity >= 2, "Heap arity must be at least 2");
+
+  static constexpr size_t kNullIndex = static_cast<size_t>(-1);
+
+  explicit IndexedHeap(Compare compare = Compare(),
+                       IndexObserver index_change_observer = IndexObserver()):
+      compare_(compare),
+      index_change_observer_(index_change_observer)
+  {}
+
+  void Push(const T& value) {
+    elements_.push_back(value);
+    SiftUp(size() - 1);
+  }
+
+  void Erase(size_t index) {
+    index_change_observer_(elements_[index], kNullIndex);
+    if (index + 1 == size()) {
+      elements_.pop_back();
+      return;
+    }
+    elements_[index] = std::move(elements_.back());
+    elements_.pop_back();
+    if (index != 0 && compare_(elements_[Parent(index)], elements_[index])) {
+      SiftUp(index);
+    } else {
+      SiftDown(index);
+    }
+  }
+
+  const T& top() const {
+    return elements_[0];
+  }
+
+  void Pop() {
+    Erase(0);
+  }
+
+  size_t size() const {
+    return elements_.size();
+  }
+
+  bool empty() const {
+    return elements_.empty();
+  }
+
+ private:
+  Compare compare_;
+  IndexObserver index_change_observer_;
+  std::vector<T> elements_;
+
+  static size_t Parent(size_t index) {
+    return (index - 1) / Arity;
+  }
+
+  void Place(size_t index, T&& value) {
+    elements_[index] = std::move(value);
+    index_change_observer_(elements_[index], index);
+  }
+
+  void SiftUp(size_t index) {
+    T value = std::move(elements_[index]);
+    while (index != 0) {
+      auto parent_index = Parent(index);
+      if (!compare_(elements_[parent_index], value)) {
+        break;
+      }
+      Place(index, std::move(elements_[parent_index]));
+      index = parent_index;
+    }
+    Place(index, std::move(value));
+  }
+
+  void SiftDown(size_t index) {
+    T value = std::move(elements_[index]);
+    while (true) {
+      auto first_son_index = Arity * index + 1;
+      if (first_son_index >= size()) {
+        break;
+      }
+      auto last_son_index = std::min(first_son_index + Arity, size());
+      auto dominating_index = first_son_index;
+      for (auto son_index = first_son_index + 1; son_index < last_son_index; ++son_index) {
+        if (compare_(elements_[dominating_index], elements_[son_index])) {
+          dominating_index = son_index;
+        }
+      }
+      if (!compare_(value, elements_[dominating_index])) {
+        break;
+      }
+      Place(index, std::move(elements_[dominating_index]));
+      index = dominating_index;
+    }
+    Place(index, std::move(value));
+  }
+};
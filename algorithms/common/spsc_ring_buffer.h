@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/*
+ * Кольцевой буфер фиксированной ёмкости без блокировок для одного
+ * писателя и одного читателя. Каждая сторона двигает только свой индекс
+ * и держит копию чужого индекса, которую перечитывает из атомарной
+ * переменной лишь тогда, когда буфер по этой копии кажется полным
+ * (или пустым). Индексы писателя и читателя лежат в разных кеш-линиях.
+ */
+
+template <class T>
+class SpscRingBuffer {
+ public:
+  explicit SpscRingBuffer(size_t capacity):
+      head_(0), cached_tail_(0), tail_(0), cached_head_(0) {
+    size_t rounded_capacity = 1;
+    while (rounded_capacity < capacity) {
+      rounded_capacity *= 2;
+    }
+    buffer_.resize(rounded_capacity);
+    mask_ = rounded_capacity - 1;
+  }
+
+  SpscRingBuffer(const SpscRingBuffer&) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+  bool TryPush(const T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == buffer_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == buffer_.size()) {
+        return false;
+      }
+    }
+    buffer_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    value = buffer_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  void Push(const T& value) {
+    while (!TryPush(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+  T Pop() {
+    T value;
+    while (!TryPop(value)) {
+      std::this_thread::yield();
+    }
+    return value;
+  }
+
+ private:
+  std::vector<T> buffer_;
+  size_t mask_;
+  alignas(64) std::atomic<size_t> head_;
+  size_t cached_tail_;
+  alignas(64) std::atomic<size_t> tail_;
+  size_t cached_head_;
+};
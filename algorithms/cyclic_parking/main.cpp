@@ -2,19 +2,40 @@
 #include <vector>
 #include <algorithm>
 #include <utility>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
-constexpr int MAX_VALUE = 200000;
+#include "../common/fast_io.h"
+#include "../common/spsc_ring_buffer.h"
 
-std::pair<int, std::vector<int>> read_input() {
-  int parking_slots;
-  std::cin >> parking_slots;
-  int number_of_events;
-  std::cin >> number_of_events;
+constexpr int LARGE_LOT_SLOTS = 1 << 16;
+constexpr int SHARDS_PER_THREAD = 4;
+constexpr int STRESS_SLOTS = 1 << 20;
+constexpr int STRESS_OPERATIONS = 1 << 23;
+constexpr int BENCHMARK_SLOTS = 10000000;
+constexpr int BENCHMARK_EVENTS = 10000000;
+constexpr int CHECK_WORDS = 8;
+constexpr int CHECK_THREADS = 4;
+constexpr int CHECK_OPERATIONS = 1 << 21;
+constexpr size_t STREAM_BUFFER_SIZE = 1 << 12;
+constexpr int END_OF_EVENTS = 0;
+constexpr int END_OF_ANSWERS = std::numeric_limits<int>::min();
+
+std::pair<int, std::vector<int>> read_input(FastReader& reader) {
+  int parking_slots = reader.ReadInteger();
+  int number_of_events = reader.ReadInteger();
   std::vector<int> events;
+  events.reserve(number_of_events);
   for (int i = 0; i < number_of_events; ++i) {
-    char type_event;
-    int event;
-    std::cin >> type_event >> event;
+    char type_event = reader.ReadChar();
+    int event = reader.ReadInteger();
     if (type_event == '+') {
       events.emplace_back(event);
     } else {
@@ -24,98 +45,523 @@ std::pair<int, std::vector<int>> read_input() {
   return std::make_pair(parking_slots, events);
 }
 
-void build_segment_tree(std::vector<int>& segment_tree, const std::vector<int>& massive,
-                        int vertex_index, int left, int right) {
-  if (left == right) {
-    segment_tree[vertex_index] = massive[left];
-  } else {
-    int middle = left + (right - left) / 2;
-    build_segment_tree(segment_tree, massive, 2 * vertex_index, left, middle);
-    build_segment_tree(segment_tree, massive, 2 * vertex_index + 1, middle + 1, right);
-    segment_tree[vertex_index] = std::min(segment_tree[2 * vertex_index],
-                                          segment_tree[2 * vertex_index + 1]);
+/*
+ * Нерекурсивное дерево отрезков над признаками «место свободно». Листья
+ * лежат в tree_[size_ .. 2 * size_), в каждой внутренней вершине хранится
+ * «в поддереве есть свободное место». Поиск первого свободного места
+ * не левее from — один проход: вверх от листа from до первой вершины,
+ * у которой правый брат непуст, и затем вниз к самому левому свободному
+ * листу. Если справа свободных мест нет, тот же проход продолжается
+ * спуском от корня, что и даёт циклический поиск.
+ */
+
+class SegmentTreeFreeSlots {
+ public:
+  explicit SegmentTreeFreeSlots(int number_of_slots) {
+    size_ = 1;
+    while (size_ < number_of_slots) {
+      size_ *= 2;
+    }
+    tree_.assign(2 * size_, 0);
+    std::fill(tree_.begin() + size_, tree_.begin() + size_ + number_of_slots, 1);
+    for (int vertex_index = size_ - 1; vertex_index > 0; --vertex_index) {
+      tree_[vertex_index] = tree_[2 * vertex_index] | tree_[2 * vertex_index + 1];
+    }
   }
-}
 
-int get_min(const std::vector<int>& segment_tree, int vertex_index,
-            int tree_left, int tree_right, int left, int right) {
-  if (left > right) {
-    return MAX_VALUE;
+  bool IsFree(int slot) const {
+    return tree_[size_ + slot];
   }
-  if (tree_left == left && tree_right == right) {
-    return segment_tree[vertex_index];
+
+  void Occupy(int slot) {
+    Update(slot, 0);
   }
-  int tree_middle = tree_left + (tree_right - tree_left) / 2;
-  return std::min(get_min(segment_tree, 2 * vertex_index, tree_left, tree_middle, left,
-                          std::min(right, tree_middle)),
-      get_min(segment_tree, 2 * vertex_index + 1, tree_middle + 1, tree_right,
-              std::max(left, tree_middle + 1), right));
-}
 
-void update(std::vector<int>& segment_tree, int vertex_index, int tree_left, int tree_right,
-            int position, int new_value) {
-  if (tree_left == tree_right) {
-    segment_tree[vertex_index] = new_value;
-  } else {
-    int tree_middle = tree_left + (tree_right - tree_left) / 2;
-    if (position <= tree_middle) {
-      update(segment_tree, 2 * vertex_index, tree_left, tree_middle, position, new_value);
-    } else {
-      update(segment_tree, 2 * vertex_index + 1, tree_middle + 1, tree_right, position, new_value);
+  void Release(int slot) {
+    Update(slot, 1);
+  }
+
+  int FindFirstFreeCyclic(int from) const {
+    if (!tree_[1]) {
+      return -1;
+    }
+    int vertex_index = size_ + from;
+    if (tree_[vertex_index]) {
+      return from;
+    }
+    while (vertex_index > 1) {
+      if ((vertex_index & 1) == 0 && tree_[vertex_index + 1]) {
+        ++vertex_index;
+        break;
+      }
+      vertex_index /= 2;
+    }
+    while (vertex_index < size_) {
+      vertex_index = tree_[2 * vertex_index] ? 2 * vertex_index : 2 * vertex_index + 1;
+    }
+    return vertex_index - size_;
+  }
+
+ private:
+  int size_;
+  std::vector<uint8_t> tree_;
+
+  void Update(int slot, uint8_t value) {
+    int vertex_index = size_ + slot;
+    tree_[vertex_index] = value;
+    for (vertex_index /= 2; vertex_index > 0; vertex_index /= 2) {
+      tree_[vertex_index] = tree_[2 * vertex_index] | tree_[2 * vertex_index + 1];
+    }
+  }
+};
+
+/*
+ * Вариант для больших стоянок: 64-ичное дерево из машинных слов.
+ * На нижнем уровне один бит — одно место, на каждом следующем бит
+ * означает «соответствующее слово уровнем ниже не нулевое». Внутри
+ * слова первый свободный бит находится через ctz, поэтому поиск и
+ * обновление стоят O(log_64 n) обращений к памяти.
+ */
+
+class BitsetFreeSlots {
+ public:
+  explicit BitsetFreeSlots(int number_of_slots) {
+    size_t bits_count = number_of_slots;
+    do {
+      size_t words_count = (bits_count + 63) / 64;
+      std::vector<uint64_t> level(words_count, ~0ULL);
+      if (bits_count % 64) {
+        level.back() = (1ULL << (bits_count % 64)) - 1;
+      }
+      levels_.push_back(std::move(level));
+      bits_count = words_count;
+    } while (bits_count > 1);
+  }
+
+  bool IsFree(int slot) const {
+    return (levels_[0][slot >> 6] >> (slot & 63)) & 1;
+  }
+
+  void Occupy(int slot) {
+    size_t position = slot;
+    for (auto &level: levels_) {
+      level[position >> 6] &= ~(1ULL << (position & 63));
+      if (level[position >> 6] != 0) {
+        return;
+      }
+      position >>= 6;
+    }
+  }
+
+  void Release(int slot) {
+    size_t position = slot;
+    for (auto &level: levels_) {
+      bool was_empty = level[position >> 6] == 0;
+      level[position >> 6] |= 1ULL << (position & 63);
+      if (!was_empty) {
+        return;
+      }
+      position >>= 6;
     }
-    segment_tree[vertex_index] = std::min(segment_tree[2 * vertex_index],
-                                          segment_tree[2 * vertex_index + 1]);
   }
+
+  int FindFirstFreeCyclic(int from) const {
+    size_t top_level = levels_.size() - 1;
+    if (levels_[top_level][0] == 0) {
+      return -1;
+    }
+    size_t position = from;
+    size_t level = 0;
+    while (true) {
+      size_t word_index = position >> 6;
+      uint64_t word = word_index < levels_[level].size() ?
+          levels_[level][word_index] & (~0ULL << (position & 63)) : 0;
+      if (word != 0) {
+        position = (word_index << 6) | __builtin_ctzll(word);
+        break;
+      }
+      if (level == top_level) {
+        position = __builtin_ctzll(levels_[top_level][0]);
+        break;
+      }
+      position = word_index + 1;
+      ++level;
+    }
+    while (level > 0) {
+      --level;
+      position = (position << 6) | __builtin_ctzll(levels_[level][position]);
+    }
+    return position;
+  }
+
+ private:
+  std::vector<std::vector<uint64_t>> levels_;
+};
+
+/*
+ * Потокобезопасная стоянка для режима сервиса. Свободные места хранятся
+ * битами в атомарных словах, слова разбиты на шарды по несколько подряд.
+ * Arrive идёт по словам циклически, начиная с предпочтительного места,
+ * пропуская шарды, в которых по счётчику нет свободных мест, и занимает
+ * младший подходящий бит слова через compare_exchange, без блокировок.
+ * Если слово перехватили, попытка повторяется с его новым значением.
+ * В однопоточном режиме ответы совпадают с FindFirstFreeCyclic.
+ */
+
+class ConcurrentParkingLot {
+ public:
+  ConcurrentParkingLot(int number_of_slots, int number_of_shards):
+      words_count_((number_of_slots + 63) / 64),
+      words_(new std::atomic<uint64_t>[words_count_]) {
+    number_of_shards = std::max(1, std::min(number_of_shards, words_count_));
+    words_per_shard_ = (words_count_ + number_of_shards - 1) / number_of_shards;
+    shards_count_ = (words_count_ + words_per_shard_ - 1) / words_per_shard_;
+    shards_.reset(new Shard[shards_count_]);
+    for (int word_index = 0; word_index < words_count_; ++word_index) {
+      int bits_count = std::min(64, number_of_slots - 64 * word_index);
+      words_[word_index].store(bits_count == 64 ? ~0ULL : (1ULL << bits_count) - 1);
+    }
+    for (int shard_index = 0; shard_index < shards_count_; ++shard_index) {
+      int first_slot = shard_index * words_per_shard_ * 64;
+      shards_[shard_index].free_slots.store(
+          std::min(number_of_slots, first_slot + words_per_shard_ * 64) - first_slot);
+    }
+  }
+
+  /*
+   * Занимает первое свободное место не левее preferred (циклически)
+   * и возвращает его номер, либо -1, если свободных мест нет. Счётчик
+   * шарда лишь подсказка: Leave увеличивает его раньше, чем выставляет
+   * бит, так что шард со свободным битом не бывает пропущен по нулевому
+   * счётчику, а прежде чем вернуть -1, слова ещё раз просматриваются
+   * подряд без подсказок.
+   */
+  int Arrive(int preferred) {
+    int first_word = preferred >> 6;
+    uint64_t preferred_mask = ~0ULL << (preferred & 63);
+    for (int step = 0; step <= words_count_; ++step) {
+      int word_index = (first_word + step) % words_count_;
+      int shard_index = word_index / words_per_shard_;
+      if (shards_[shard_index].free_slots.load(std::memory_order_acquire) <= 0) {
+        int shard_end = std::min(words_count_, (shard_index + 1) * words_per_shard_);
+        if (step < words_count_) {
+          step += std::min(shard_end - 1 - word_index, words_count_ - 1 - step);
+        }
+        continue;
+      }
+      int slot = TryClaimInWord(word_index, StepMask(step, preferred_mask));
+      if (slot != -1) {
+        return slot;
+      }
+    }
+    for (int step = 0; step <= words_count_; ++step) {
+      int slot = TryClaimInWord((first_word + step) % words_count_,
+                                StepMask(step, preferred_mask));
+      if (slot != -1) {
+        return slot;
+      }
+    }
+    return -1;
+  }
+
+  /*
+   * Освобождает место slot. Возвращает false, если оно и так было свободно.
+   */
+  bool Leave(int slot) {
+    uint64_t bit = 1ULL << (slot & 63);
+    auto &free_slots = shards_[(slot >> 6) / words_per_shard_].free_slots;
+    free_slots.fetch_add(1, std::memory_order_release);
+    uint64_t previous = words_[slot >> 6].fetch_or(bit, std::memory_order_acq_rel);
+    if (previous & bit) {
+      free_slots.fetch_sub(1, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<int> free_slots;
+  };
+
+  int words_count_;
+  int words_per_shard_;
+  int shards_count_;
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  std::unique_ptr<Shard[]> shards_;
+
+  /*
+   * Маска допустимых битов слова на шаге step обхода: в первом слове
+   * места не левее preferred, в последнем (том же слове после круга) —
+   * левее него.
+   */
+  uint64_t StepMask(int step, uint64_t preferred_mask) const {
+    if (step == 0) {
+      return preferred_mask;
+    }
+    return step == words_count_ ? ~preferred_mask : ~0ULL;
+  }
+
+  int TryClaimInWord(int word_index, uint64_t mask) {
+    uint64_t word = words_[word_index].load(std::memory_order_acquire);
+    while ((word & mask) != 0) {
+      uint64_t bit = (word & mask) & (0 - (word & mask));
+      if (words_[word_index].compare_exchange_weak(word, word & ~bit,
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+        shards_[word_index / words_per_shard_].free_slots.fetch_sub(
+            1, std::memory_order_relaxed);
+        return word_index * 64 + __builtin_ctzll(bit);
+      }
+    }
+    return -1;
+  }
+};
+
+template <class FreeSlots>
+int process_event(FreeSlots& free_slots, int event) {
+  if (event > 0) {
+    auto slot = free_slots.FindFirstFreeCyclic(event - 1);
+    if (slot == -1) {
+      return -1;
+    }
+    free_slots.Occupy(slot);
+    return slot + 1;
+  }
+  if (!free_slots.IsFree(-event - 1)) {
+    free_slots.Release(-event - 1);
+    return 0;
+  }
+  return -2;
 }
 
-std::vector<int> get_answers(std::pair<int, std::vector<int>> input) {
+template <class FreeSlots>
+std::vector<int> get_answers(const std::pair<int, std::vector<int>>& input) {
   auto number_of_parking_slots = input.first;
-  auto events = input.second;
-  std::vector<int> parking_slots;
-  for (int i = 0; i < number_of_parking_slots; ++i) {
-    parking_slots.emplace_back(i + 1);
-  }
+  const auto &events = input.second;
+  FreeSlots free_slots(number_of_parking_slots);
   std::vector<int> answers;
-  std::vector<int> tree(4 * number_of_parking_slots);
-  build_segment_tree(tree, parking_slots, 1, 0, number_of_parking_slots - 1);
+  answers.reserve(events.size());
   for (auto &event: events) {
-    if (event > 0) {
-      auto min_element = get_min(tree, 1, 0, number_of_parking_slots - 1,
-                                 event - 1, number_of_parking_slots - 1);
-      if (min_element == MAX_VALUE) {
-        auto min_element = get_min(tree, 1, 0, number_of_parking_slots - 1, 0, event - 2);
-        if (min_element == MAX_VALUE) {
-          answers.emplace_back(-1);
-        } else {
-          answers.emplace_back(min_element);
-          update(tree, 1, 0, number_of_parking_slots - 1, min_element - 1, MAX_VALUE);
+    answers.emplace_back(process_event(free_slots, event));
+  }
+  return answers;
+}
+
+/*
+ * Потоковый режим: события не накапливаются в памяти. Отдельный поток
+ * разбирает вход и кладёт события в кольцевой буфер, основной поток
+ * обрабатывает их и кладёт ответы во второй буфер, а третий поток
+ * форматирует ответы и пишет их в выход. Память, кроме самой стоянки,
+ * ограничена размером буферов. Вход читается до number_of_events событий
+ * или до его конца, если событий меньше.
+ */
+
+template <class FreeSlots>
+void process_stream(int number_of_parking_slots, int number_of_events,
+                    FastReader& reader, FastWriter& writer) {
+  SpscRingBuffer<int> events(STREAM_BUFFER_SIZE);
+  SpscRingBuffer<int> answers(STREAM_BUFFER_SIZE);
+  std::thread parser([&]() {
+    for (int i = 0; i < number_of_events && reader.SkipSpaces(); ++i) {
+      char type_event = reader.ReadChar();
+      int event = reader.ReadInteger();
+      events.Push(type_event == '+' ? event : -event);
+    }
+    events.Push(END_OF_EVENTS);
+  });
+  std::thread formatter([&]() {
+    for (int answer = answers.Pop(); answer != END_OF_ANSWERS; answer = answers.Pop()) {
+      writer.WriteInteger(answer);
+      writer.WriteChar('\n');
+    }
+  });
+  FreeSlots free_slots(number_of_parking_slots);
+  for (int event = events.Pop(); event != END_OF_EVENTS; event = events.Pop()) {
+    answers.Push(process_event(free_slots, event));
+  }
+  answers.Push(END_OF_ANSWERS);
+  parser.join();
+  formatter.join();
+}
+
+void write_answers(const std::vector<int>& answers, FastWriter& writer) {
+  for (auto &answer: answers) {
+    writer.WriteInteger(answer);
+    writer.WriteChar('\n');
+  }
+}
+
+/*
+ * Нагрузочный режим: threads_count потоков поровну делят STRESS_OPERATIONS
+ * случайных приездов и отъездов на общей стоянке. Возвращает число
+ * операций в секунду.
+ */
+
+double run_stress(int threads_count) {
+  ConcurrentParkingLot parking_lot(STRESS_SLOTS, threads_count * SHARDS_PER_THREAD);
+  auto worker = [&](int thread_index) {
+    std::mt19937 generator(thread_index);
+    std::uniform_int_distribution<int> gen_uniform_slot(0, STRESS_SLOTS - 1);
+    std::vector<int> occupied_slots;
+    for (int i = 0; i < STRESS_OPERATIONS / threads_count; ++i) {
+      if (occupied_slots.empty() || generator() % 2 == 0) {
+        int slot = parking_lot.Arrive(gen_uniform_slot(generator));
+        if (slot != -1) {
+          occupied_slots.push_back(slot);
         }
       } else {
-        answers.emplace_back(min_element);
-        update(tree, 1, 0, number_of_parking_slots - 1, min_element - 1, MAX_VALUE);
-      }
-    } else {
-      if (get_min(tree, 1, 0, number_of_parking_slots - 1,
-                  -event - 1, number_of_parking_slots - 1) != -event) {
-        answers.emplace_back(0);
-        update(tree, 1, 0, number_of_parking_slots - 1, -event - 1, -event);
-      } else {
-        answers.emplace_back(-2);
+        size_t index = generator() % occupied_slots.size();
+        parking_lot.Leave(occupied_slots[index]);
+        occupied_slots[index] = occupied_slots.back();
+        occupied_slots.pop_back();
       }
     }
+  };
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < threads_count; ++thread_index) {
+    threads.emplace_back(worker, thread_index);
   }
-  return answers;
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return STRESS_OPERATIONS / elapsed.count();
 }
 
-void write_answers(const std::vector<int>& answers) {
-  for (auto &answer: answers) {
-    std::cout << answer << "\n";
+void write_stress_report(FastWriter& writer) {
+  int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int threads_count = 1; ; threads_count = std::min(2 * threads_count, max_threads)) {
+    writer.WriteFormatted("%d threads: %.0f ops/sec\n", threads_count, run_stress(threads_count));
+    if (threads_count == max_threads) {
+      break;
+    }
+  }
+}
+
+/*
+ * Бенчмарк (--bench): BENCHMARK_EVENTS случайных событий на стоянке из
+ * BENCHMARK_SLOTS мест, три пятых из них — приезды, остальные — отъезды
+ * со случайных мест (занятых или нет). Одни и те же события проходят
+ * через get_answers с обеими структурами свободных мест; контрольные
+ * суммы ответов должны совпасть.
+ */
+
+void write_benchmark(FastWriter& writer) {
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> gen_uniform_slot(1, BENCHMARK_SLOTS);
+  std::pair<int, std::vector<int>> input(BENCHMARK_SLOTS, std::vector<int>(BENCHMARK_EVENTS));
+  for (auto &event: input.second) {
+    int slot = gen_uniform_slot(generator);
+    event = generator() % 5 < 3 ? slot : -slot;
+  }
+  auto measure = [&](const char* name, auto get_answers_with) {
+    auto start = std::chrono::steady_clock::now();
+    auto answers = get_answers_with();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t checksum = 0;
+    for (auto answer: answers) {
+      checksum = checksum * 1000003 + static_cast<uint32_t>(answer);
+    }
+    writer.WriteFormatted("%s: %.3f s, %.1f ns per event, checksum %llx\n", name,
+                          elapsed.count(), elapsed.count() * 1e9 / answers.size(),
+                          static_cast<unsigned long long>(checksum));
+  };
+  writer.WriteFormatted("%d slots, %d events\n", BENCHMARK_SLOTS, BENCHMARK_EVENTS);
+  measure("segment tree", [&]() {
+    return get_answers<SegmentTreeFreeSlots>(input);
+  });
+  measure("bitset", [&]() {
+    return get_answers<BitsetFreeSlots>(input);
+  });
+}
+
+/*
+ * Проверка (--check) стоянки под конкурентной нагрузкой. Потоки
+ * приезжают и уезжают на маленькой стоянке, причём каждый держит не
+ * больше своей доли мест, так что занято всегда меньше, чем есть:
+ * Arrive не должен возвращать -1, и никакое место не должно достаться
+ * двум машинам сразу (это отслеживается отдельным массивом владельцев).
+ */
+
+void check_concurrent_parking_lot(FastWriter& writer) {
+  constexpr int slots_count = CHECK_WORDS * 64;
+  constexpr int slots_per_thread = (slots_count - 1) / CHECK_THREADS;
+  ConcurrentParkingLot parking_lot(slots_count, CHECK_WORDS);
+  std::unique_ptr<std::atomic<int>[]> owners(new std::atomic<int>[slots_count]);
+  for (int slot = 0; slot < slots_count; ++slot) {
+    owners[slot].store(0);
+  }
+  std::atomic<long long> failed_arrivals(0);
+  std::atomic<long long> double_bookings(0);
+  auto worker = [&](int thread_index) {
+    std::mt19937 generator(thread_index);
+    std::vector<int> occupied_slots;
+    for (int i = 0; i < CHECK_OPERATIONS; ++i) {
+      bool can_arrive = static_cast<int>(occupied_slots.size()) < slots_per_thread;
+      if (can_arrive && (occupied_slots.empty() || generator() % 2 == 0)) {
+        int slot = parking_lot.Arrive(generator() % slots_count);
+        if (slot == -1) {
+          ++failed_arrivals;
+          continue;
+        }
+        if (owners[slot].exchange(thread_index + 1) != 0) {
+          ++double_bookings;
+        }
+        occupied_slots.push_back(slot);
+      } else {
+        size_t index = generator() % occupied_slots.size();
+        owners[occupied_slots[index]].store(0);
+        parking_lot.Leave(occupied_slots[index]);
+        occupied_slots[index] = occupied_slots.back();
+        occupied_slots.pop_back();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < CHECK_THREADS; ++thread_index) {
+    threads.emplace_back(worker, thread_index);
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  writer.WriteFormatted("%d threads, %d slots: %lld failed arrivals, %lld double bookings\n",
+                        CHECK_THREADS, slots_count, failed_arrivals.load(),
+                        double_bookings.load());
+  if (failed_arrivals.load() != 0 || double_bookings.load() != 0) {
+    throw std::runtime_error("ConcurrentParkingLot check failed");
   }
 }
 
-int main() {
-  auto input = read_input();
-  auto answers = get_answers(input);
-  write_answers(answers);
+int main(int argc, char* argv[]) {
+  FastWriter writer;
+  if (argc > 1 && std::string(argv[1]) == "--bench") {
+    write_benchmark(writer);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "--stress") {
+    write_stress_report(writer);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "--check") {
+    check_concurrent_parking_lot(writer);
+    return 0;
+  }
+  FastReader reader;
+  if (argc > 1 && std::string(argv[1]) == "--stream") {
+    int parking_slots = reader.ReadInteger();
+    int number_of_events = reader.ReadInteger();
+    if (parking_slots < LARGE_LOT_SLOTS) {
+      process_stream<SegmentTreeFreeSlots>(parking_slots, number_of_events, reader, writer);
+    } else {
+      process_stream<BitsetFreeSlots>(parking_slots, number_of_events, reader, writer);
+    }
+    return 0;
+  }
+  auto input = read_input(reader);
+  auto answers = input.first < LARGE_LOT_SLOTS ?
+      get_answers<SegmentTreeFreeSlots>(input) : get_answers<BitsetFreeSlots>(input);
+  write_answers(answers, writer);
   return 0;
 }
@@ -3,194 +3,1407 @@
 #include <random>
 #include <functional>
 #include <chrono>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <memory>
+#include <optional>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-constexpr int64_t PRIME_NUMBER = 2147483323;
-constexpr int64_t NAN_VALUE = 1000000001;
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-struct Bucket {
-  int first_hash_parameter;
-  int second_hash_parameter;
-  std::vector<int> hashed_keys;
-  Bucket()
+#include "../common/fast_io.h"
+
+constexpr size_t BATCH_SIZE = 16;
+static_assert(BATCH_SIZE % 4 == 0, "Vector hash kernels process keys in groups of four");
+constexpr size_t BENCHMARK_KEYS_COUNT = 1 << 17;
+constexpr size_t BENCHMARK_QUERIES_COUNT = 1 << 22;
+constexpr size_t PARALLEL_CHUNK_SIZE = 1 << 14;
+constexpr uint32_t SNAPSHOT_VERSION = 3;
+constexpr char SNAPSHOT_MAGIC[8] = "FIXDSET";
+constexpr size_t MAX_HASH_PARAMETERS_SIZE = 16;
+
+/*
+ * Ключ фиксированной длины, например идентификатор или хеш-сумма.
+ */
+
+template <size_t Length>
+struct FixedString {
+  std::array<char, Length> data;
+  friend bool operator==(const FixedString& first, const FixedString& second) {
+    return first.data == second.data;
+  }
+};
+
+/*
+ * Все семейства хеш-функций работают с ключом как с последовательностью
+ * 32-битных кусков. Различные ключи дают различные последовательности,
+ * так что вероятность коллизии определяется только семейством. Число
+ * кусков известно на этапе компиляции, и циклы по ним разворачиваются.
+ */
+
+template <class T, class Enable = void>
+struct KeyChunks;
+
+template <class T>
+struct KeyChunks<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+  static constexpr size_t COUNT = sizeof(T) <= 4 ? 1 : 2;
+  static uint32_t Get(T key, size_t index) {
+    return static_cast<uint32_t>(static_cast<uint64_t>(key) >> (32 * index));
+  }
+};
+
+template <size_t Length>
+struct KeyChunks<FixedString<Length>> {
+  static constexpr size_t COUNT = (Length + 3) / 4;
+  static uint32_t Get(const FixedString<Length>& key, size_t index) {
+    uint32_t chunk = 0;
+    std::memcpy(&chunk, key.data.data() + 4 * index, std::min<size_t>(4, Length - 4 * index));
+    return chunk;
+  }
+};
+
+/*
+ * Отображает 32-битное значение хеша на [0, table_size) умножением
+ * вместо деления.
+ */
+
+inline uint32_t ReduceToTable(uint32_t hash_value, uint32_t table_size) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(hash_value) * table_size) >> 32);
+}
+
+/*
+ * Семейство хеш-функций задаётся политикой: типом Parameters с параметрами
+ * одного уровня, функцией Generate, выбирающей случайную функцию семейства,
+ * и функцией Hash. Все они статические, поэтому горячий путь Contains
+ * целиком подставляется и специализируется под тип ключа.
+ */
+
+template <class T>
+struct ModPrimeHash {
+  static constexpr uint32_t ID = 1;
+  static constexpr uint64_t PRIME = (1ULL << 61) - 1;
+
+  struct Parameters {
+    uint64_t multiplier;
+    uint64_t increment;
+  };
+
+  template <class Generator>
+  static Parameters Generate(Generator& generator) {
+    std::uniform_int_distribution<uint64_t> gen_uniform_multiplier(1, PRIME - 1);
+    std::uniform_int_distribution<uint64_t> gen_uniform_increment(0, PRIME - 1);
+    Parameters parameters;
+    parameters.multiplier = gen_uniform_multiplier(generator);
+    parameters.increment = gen_uniform_increment(generator);
+    return parameters;
+  }
+
+  static uint64_t Fold(uint64_t value) {
+    return (value & PRIME) + (value >> 61);
+  }
+
+  static uint64_t MultiplyModPrime(uint64_t first, uint64_t second) {
+    unsigned __int128 product = static_cast<unsigned __int128>(first) * second;
+    uint64_t result = Fold((static_cast<uint64_t>(product) & PRIME) +
+                           static_cast<uint64_t>(product >> 61));
+    return result >= PRIME ? result - PRIME : result;
+  }
+
+  static uint32_t Hash(const T& key, const Parameters& parameters, uint32_t table_size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < KeyChunks<T>::COUNT; ++i) {
+      value = MultiplyModPrime(value + KeyChunks<T>::Get(key, i), parameters.multiplier);
+    }
+    value += parameters.increment;
+    if (value >= PRIME) {
+      value -= PRIME;
+    }
+    return value % table_size;
+  }
+};
+
+template <class T>
+struct MultiplyShiftHash {
+  static constexpr uint32_t ID = 2;
+
+  struct Parameters {
+    uint64_t multiplier;
+    uint64_t increment;
+  };
+
+  template <class Generator>
+  static Parameters Generate(Generator& generator) {
+    Parameters parameters;
+    parameters.multiplier = generator() | 1;
+    parameters.increment = generator();
+    return parameters;
+  }
+
+  /*
+   * Для ключей из нескольких кусков множитель каждого следующего куска
+   * получается из предыдущего шагом линейного конгруэнтного генератора.
+   */
+
+  static uint32_t Hash(const T& key, const Parameters& parameters, uint32_t table_size) {
+    uint64_t value = parameters.increment;
+    uint64_t multiplier = parameters.multiplier;
+    for (size_t i = 0; i < KeyChunks<T>::COUNT; ++i) {
+      value += multiplier * KeyChunks<T>::Get(key, i);
+      multiplier = multiplier * 0x5851F42D4C957F2DULL + parameters.increment;
+    }
+    return ReduceToTable(static_cast<uint32_t>(value >> 32), table_size);
+  }
+};
+
+struct TabulationTable {
+  uint64_t values[8][256];
+};
+
+constexpr TabulationTable MakeTabulationTable() {
+  TabulationTable table{};
+  uint64_t state = 0x243F6A8885A308D3ULL;
+  for (size_t position = 0; position < 8; ++position) {
+    for (size_t byte = 0; byte < 256; ++byte) {
+      uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+      value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+      table.values[position][byte] = value ^ (value >> 31);
+    }
+  }
+  return table;
+}
+
+constexpr TabulationTable TABULATION_TABLE = MakeTabulationTable();
+
+/*
+ * Простое табуляционное хеширование по байтам ключа. Таблица общая
+ * и строится при компиляции, а случайность уровня вносится параметрами:
+ * байты ключа перед поиском в таблице складываются по модулю 2 с байтами
+ * seed, а результат проходит через multiply-shift.
+ */
+
+template <class T>
+struct TabulationHash {
+  static constexpr uint32_t ID = 3;
+
+  struct Parameters {
+    uint64_t seed;
+    uint64_t multiplier;
+  };
+
+  template <class Generator>
+  static Parameters Generate(Generator& generator) {
+    Parameters parameters;
+    parameters.seed = generator();
+    parameters.multiplier = generator() | 1;
+    return parameters;
+  }
+
+  static uint32_t Hash(const T& key, const Parameters& parameters, uint32_t table_size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < KeyChunks<T>::COUNT; ++i) {
+      uint32_t chunk = KeyChunks<T>::Get(key, i);
+      for (size_t j = 0; j < 4; ++j) {
+        size_t position = (4 * i + j) % 8;
+        uint8_t byte = (chunk >> (8 * j)) ^ (parameters.seed >> (8 * position));
+        uint64_t entry = TABULATION_TABLE.values[position][byte];
+        size_t rotation = (4 * i + j) / 8 % 64;
+        value ^= rotation ? (entry << rotation) | (entry >> (64 - rotation)) : entry;
+      }
+    }
+    return ReduceToTable(static_cast<uint32_t>((value * parameters.multiplier) >> 32),
+                         table_size);
+  }
+};
+
+/*
+ * Все бакеты второго уровня упакованы в один непрерывный массив keys.
+ * Для каждого бакета первого уровня мы храним лишь смещение его таблицы
+ * в этом массиве, её размер и параметры хеш-функции, поэтому Contains
+ * читает ровно один заголовок бакета и одну ячейку с ключом. Заголовок
+ * с 16 байтами параметров занимает 24 байта, и без выравнивания каждый
+ * восьмой пересекал бы границу кеш-линии; выровненный по 32 байтам, он
+ * всегда лежит в одной линии. Выравнивающие байты явные и нулевые, чтобы
+ * снимок не зависел от мусора в памяти.
+ */
+
+template <class Parameters>
+struct alignas(32) Bucket {
+  uint32_t offset;
+  uint32_t size;
+  Parameters hash_parameters;
+  uint8_t reserved[32 - 2 * sizeof(uint32_t) - sizeof(Parameters)];
+  Bucket(): offset(0), size(0), hash_parameters(), reserved()
   {}
-  Bucket(int first_hash_parameter_, int second_hash_parameter_,
-         const std::vector<int>& hashed_keys_):
-      first_hash_parameter(first_hash_parameter_), second_hash_parameter(second_hash_parameter_),
-      hashed_keys(hashed_keys_)
+  Bucket(uint32_t offset_, uint32_t size_):
+      offset(offset_), size(size_), hash_parameters(), reserved()
   {}
 };
 
+static_assert(64 % sizeof(Bucket<uint8_t[MAX_HASH_PARAMETERS_SIZE]>) == 0,
+              "Bucket header must not straddle a cache line");
 
+/*
+ * Пакетное вычисление multiply-shift для ключей из одного 32-битного
+ * куска, то же, что MultiplyShiftHash::Hash. Произведение 64 x 32
+ * собирается из двух умножений 32 x 32 -> 64 (младшая и старшая половины
+ * множителя). Front хеширует ключи общими параметрами первого уровня,
+ * InBuckets — параметрами и размерами таблиц из заголовков бакетов, по
+ * одному бакету на ключ; они читаются прямо из заголовков, без
+ * промежуточных массивов, которые векторное чтение вынуждало бы ждать
+ * окончания скалярных записей. count кратен четырём. Реализация
+ * выбирается один раз при запуске по возможностям процессора: AVX2
+ * (4 ключа за операцию), SSE2 (2 ключа) или скалярная.
+ */
+
+template <class BucketType>
+struct MultiplyShiftKernels {
+  using Parameters = decltype(BucketType::hash_parameters);
+  typedef void (*FrontKernel)(const uint32_t* chunks, const Parameters& parameters,
+                              uint32_t table_size, uint32_t* hashes, size_t count);
+  typedef void (*InBucketsKernel)(const uint32_t* chunks, const BucketType* const* buckets,
+                                  uint32_t* hashes, size_t count);
+
+  const char* name;
+  FrontKernel front;
+  InBucketsKernel in_buckets;
+
+  static void FrontScalar(const uint32_t* chunks, const Parameters& parameters,
+                          uint32_t table_size, uint32_t* hashes, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t value = parameters.increment + parameters.multiplier * chunks[i];
+      hashes[i] = ReduceToTable(static_cast<uint32_t>(value >> 32), table_size);
+    }
+  }
+
+  static void InBucketsScalar(const uint32_t* chunks, const BucketType* const* buckets,
+                              uint32_t* hashes, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      const auto &parameters = buckets[i]->hash_parameters;
+      uint64_t value = parameters.increment + parameters.multiplier * chunks[i];
+      hashes[i] = ReduceToTable(static_cast<uint32_t>(value >> 32), buckets[i]->size);
+    }
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+  __attribute__((target("sse2")))
+  static __m128i HashSse2(__m128i chunk, __m128i multiplier, __m128i increment,
+                          __m128i table_size) {
+    __m128i value = _mm_add_epi64(increment, _mm_mul_epu32(multiplier, chunk));
+    value = _mm_add_epi64(value, _mm_slli_epi64(
+        _mm_mul_epu32(_mm_srli_epi64(multiplier, 32), chunk), 32));
+    __m128i reduced = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(value, 32), table_size), 32);
+    return _mm_shuffle_epi32(reduced, _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  __attribute__((target("sse2")))
+  static __m128i LoadChunksSse2(const uint32_t* chunks) {
+    return _mm_unpacklo_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(chunks)),
+                              _mm_setzero_si128());
+  }
+
+  __attribute__((target("sse2")))
+  static void FrontSse2(const uint32_t* chunks, const Parameters& parameters,
+                        uint32_t table_size, uint32_t* hashes, size_t count) {
+    __m128i multiplier = _mm_set1_epi64x(parameters.multiplier);
+    __m128i increment = _mm_set1_epi64x(parameters.increment);
+    __m128i table_sizes = _mm_set1_epi64x(table_size);
+    for (size_t i = 0; i < count; i += 2) {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(hashes + i), HashSse2(
+          LoadChunksSse2(chunks + i), multiplier, increment, table_sizes));
+    }
+  }
+
+  __attribute__((target("sse2")))
+  static void InBucketsSse2(const uint32_t* chunks, const BucketType* const* buckets,
+                            uint32_t* hashes, size_t count) {
+    for (size_t i = 0; i < count; i += 2) {
+      __m128i multiplier = _mm_set_epi64x(buckets[i + 1]->hash_parameters.multiplier,
+                                          buckets[i]->hash_parameters.multiplier);
+      __m128i increment = _mm_set_epi64x(buckets[i + 1]->hash_parameters.increment,
+                                         buckets[i]->hash_parameters.increment);
+      __m128i table_size = _mm_set_epi64x(buckets[i + 1]->size, buckets[i]->size);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(hashes + i), HashSse2(
+          LoadChunksSse2(chunks + i), multiplier, increment, table_size));
+    }
+  }
+
+  __attribute__((target("avx2")))
+  static __m128i HashAvx2(__m128i chunks, __m256i multiplier, __m256i increment,
+                          __m256i table_size) {
+    __m256i chunk = _mm256_cvtepu32_epi64(chunks);
+    __m256i value = _mm256_add_epi64(increment, _mm256_mul_epu32(multiplier, chunk));
+    value = _mm256_add_epi64(value, _mm256_slli_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(multiplier, 32), chunk), 32));
+    __m256i reduced = _mm256_srli_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(value, 32), table_size), 32);
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+        reduced, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7)));
+  }
+
+  __attribute__((target("avx2")))
+  static void FrontAvx2(const uint32_t* chunks, const Parameters& parameters,
+                        uint32_t table_size, uint32_t* hashes, size_t count) {
+    __m256i multiplier = _mm256_set1_epi64x(parameters.multiplier);
+    __m256i increment = _mm256_set1_epi64x(parameters.increment);
+    __m256i table_sizes = _mm256_set1_epi64x(table_size);
+    for (size_t i = 0; i < count; i += 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(hashes + i), HashAvx2(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunks + i)),
+          multiplier, increment, table_sizes));
+    }
+  }
+
+  __attribute__((target("avx2")))
+  static void InBucketsAvx2(const uint32_t* chunks, const BucketType* const* buckets,
+                            uint32_t* hashes, size_t count) {
+    for (size_t i = 0; i < count; i += 4) {
+      const BucketType* const* group = buckets + i;
+      __m256i multiplier = _mm256_set_epi64x(
+          group[3]->hash_parameters.multiplier, group[2]->hash_parameters.multiplier,
+          group[1]->hash_parameters.multiplier, group[0]->hash_parameters.multiplier);
+      __m256i increment = _mm256_set_epi64x(
+          group[3]->hash_parameters.increment, group[2]->hash_parameters.increment,
+          group[1]->hash_parameters.increment, group[0]->hash_parameters.increment);
+      __m256i table_size = _mm256_set_epi64x(group[3]->size, group[2]->size,
+                                             group[1]->size, group[0]->size);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(hashes + i), HashAvx2(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunks + i)),
+          multiplier, increment, table_size));
+    }
+  }
+
+#endif
+
+  /*
+   * Все реализации, которые может выполнить этот процессор, от самой
+   * быстрой к скалярной.
+   */
+  static std::vector<MultiplyShiftKernels> GetSupported() {
+    std::vector<MultiplyShiftKernels> kernels;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      kernels.push_back({"avx2", FrontAvx2, InBucketsAvx2});
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      kernels.push_back({"sse2", FrontSse2, InBucketsSse2});
+    }
+#endif
+    kernels.push_back({"scalar", FrontScalar, InBucketsScalar});
+    return kernels;
+  }
+
+  static const MultiplyShiftKernels& Get() {
+    static const MultiplyShiftKernels kernels = GetSupported().front();
+    return kernels;
+  }
+};
+
+/*
+ * Снимок FixedSet на диске: заголовок SnapshotHeader, за ним массив
+ * заголовков бакетов и массив ключей ровно в том виде, в каком они лежат
+ * в памяти (порядок байт — родной для машины). Поэтому открытие снимка —
+ * это mmap и проверка заголовка, без какого-либо разбора, а страницы
+ * таблицы разделяются всеми процессами через page cache. Размер ключа
+ * и семейство хеш-функций записаны в заголовок, чтобы снимок нельзя было
+ * открыть как FixedSet другого типа.
+ */
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;
+  uint32_t hash_family;
+  uint32_t bucket_size;
+  uint64_t buckets_count;
+  uint64_t keys_count;
+  uint8_t front_hash_parameters[MAX_HASH_PARAMETERS_SIZE];
+  uint8_t padding[8];
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "SnapshotHeader must occupy one cache line");
+
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor == -1) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat file_stat;
+    if (fstat(descriptor, &file_stat) == -1) {
+      close(descriptor);
+      throw std::runtime_error("Cannot stat " + path);
+    }
+    size_ = file_stat.st_size;
+    data_ = size_ ? mmap(nullptr, size_, PROT_READ, MAP_SHARED, descriptor, 0) : nullptr;
+    close(descriptor);
+    if (data_ == MAP_FAILED) {
+      throw std::runtime_error("Cannot mmap " + path);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+    if (data_) {
+      munmap(data_, size_);
+    }
+  }
+
+  const char* data() const {
+    return static_cast<const char*>(data_);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  void* data_;
+  size_t size_;
+};
+
+class steady_timer {
+ public:
+  steady_timer() {
+    reset();
+  }
+
+  void reset() {
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  double seconds_elapsed() const {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast< std::chrono::duration<double> >(now - start_);
+    return elapsed.count();
+  }
 
-template <class T, class HashFunction>
-class FixedSet {
  private:
-  std::vector<Bucket> hash_table;
-  std::vector<bool> front_buckets;
-  int front_first_hash_function_parameter;
-  int front_second_hash_function_parameter;
-  int GetFrontFirstHashParameter() const {
-    return front_first_hash_function_parameter;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/*
+ * Дешёвый генератор, который можно завести отдельно для каждого бакета:
+ * параметры бакета зависят только от seed и номера бакета, а не от того,
+ * каким потоком и в каком порядке он был построен.
+ */
+
+class SplitMix64 {
+ public:
+  using result_type = uint64_t;
+
+  explicit SplitMix64(uint64_t seed): state(seed)
+  {}
+
+  static constexpr result_type min() {
+    return 0;
+  }
+
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
   }
-  int GetFrontSecondHashParameter() const {
-    return front_second_hash_function_parameter;
+
+  result_type operator()() {
+    uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
   }
-  const std::vector<bool>& GetFrontBuckets() const {
-    return front_buckets;
+
+ private:
+  uint64_t state;
+};
+
+/*
+ * Выполняет function(begin, end) над отрезками [0, count) длины
+ * PARALLEL_CHUNK_SIZE. Потоки забирают очередной отрезок из общего
+ * счётчика, так что освободившийся поток сразу берёт следующую работу.
+ */
+
+template <class Function>
+void ParallelFor(size_t count, unsigned threads_count, Function function) {
+  std::atomic<size_t> next_chunk(0);
+  auto worker = [&]() {
+    for (size_t begin = next_chunk.fetch_add(PARALLEL_CHUNK_SIZE); begin < count;
+         begin = next_chunk.fetch_add(PARALLEL_CHUNK_SIZE)) {
+      function(begin, std::min(count, begin + PARALLEL_CHUNK_SIZE));
+    }
+  };
+  size_t chunks_count = (count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+  threads_count = std::max<size_t>(1, std::min<size_t>(threads_count, chunks_count));
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threads_count; ++i) {
+    threads.emplace_back(worker);
   }
-  const std::vector<Bucket>& GetHashTable() const {
-    return hash_table;
+  worker();
+  for (auto &thread: threads) {
+    thread.join();
   }
+}
+
+/*
+ * Если seed не задан, он берётся из std::random_device.
+ */
+struct BuildOptions {
+  unsigned threads_count;
+  std::optional<uint64_t> seed;
+  BuildOptions(): threads_count(std::max(1u, std::thread::hardware_concurrency()))
+  {}
+};
 
+struct BuildPhaseStatistics {
+  double seconds = 0;
+  size_t memory_bytes = 0;
+};
+
+struct BuildStatistics {
+  int first_level_attempts = 0;
+  BuildPhaseStatistics partition;
+  BuildPhaseStatistics second_level;
+};
+
+/*
+ * Таблица читается через указатели buckets и keys, которые смотрят либо
+ * в собственные векторы owned_buckets и owned_keys (после Initialize),
+ * либо в отображённый в память снимок (после Open).
+ *
+ * Пустые ячейки таблиц второго уровня заполнены каким-нибудь ключом того же
+ * бакета. Совпадение запроса с таким ключом всё равно означает, что запрос
+ * лежит в множестве, поэтому отдельная метка пустой ячейки не нужна и
+ * ключом может быть любой тип.
+ */
+
+template <class T, class HashFunction = MultiplyShiftHash<T>>
+class FixedSet {
  public:
-  FixedSet() {}
-  void Initialize(const std::vector<int>& numbers);
-  bool Contains(int number) const;
+  using HashParameters = typename HashFunction::Parameters;
+  using BucketType = Bucket<HashParameters>;
+
+  static_assert(std::is_trivially_copyable<T>::value, "FixedSet keys must be trivially copyable");
+  static_assert(std::is_trivially_copyable<HashParameters>::value &&
+                sizeof(HashParameters) <= MAX_HASH_PARAMETERS_SIZE,
+                "Hash parameters must fit into the snapshot header");
+
+  FixedSet(): buckets(nullptr), buckets_count(0), keys(nullptr), keys_count(0),
+              front_hash_parameters()
+  {}
+  void Initialize(const std::vector<T>& numbers, const BuildOptions& options = BuildOptions());
+  void Save(const std::string& path) const;
+  void WriteSnapshot(std::ostream& stream) const;
+  void Open(const std::string& path);
+  bool Contains(const T& number) const;
+  void ContainsBatch(const T* numbers, size_t count, uint8_t* answers) const;
+  const BuildStatistics& GetBuildStatistics() const {
+    return build_statistics;
+  }
+
+ private:
+  std::vector<BucketType> owned_buckets;
+  std::vector<T> owned_keys;
+  std::unique_ptr<MappedFile> mapped_snapshot;
+  const BucketType* buckets;
+  size_t buckets_count;
+  const T* keys;
+  size_t keys_count;
+  HashParameters front_hash_parameters;
+  BuildStatistics build_statistics;
+
+  static constexpr bool VECTOR_HASHING =
+      std::is_same<HashFunction, MultiplyShiftHash<T>>::value && KeyChunks<T>::COUNT == 1;
+
+  void BuildBucket(const T* bucket_keys, uint32_t bucket_size, uint64_t seed,
+                   size_t number_of_bucket);
+  void AttachOwnedStorage();
+  void ContainsBatchVectorized(const T* numbers, size_t count, uint8_t* answers) const;
 };
 
+/*
+ * Построение идёт в две фазы. Сначала ключи раскладываются по бакетам
+ * первого уровня сортировкой подсчётом: на каждой попытке параллельно
+ * считаются лишь размеры бакетов, а сами ключи переносятся в общий массив
+ * partitioned_keys один раз, когда сумма квадратов размеров подошла.
+ * Затем бакеты второго уровня строятся независимо друг от друга
+ * в ParallelFor, каждый со своим генератором, заведённым от seed.
+ * Порядок ключей внутри бакета после параллельной раскладки зависит от
+ * потоков, поэтому пустые ячейки таблицы бакета заполняются ключом из её
+ * первой занятой ячейки: при заданном seed снимок побайтно одинаков при
+ * любом числе потоков.
+ */
 
-int hash_function(int number, int number_of_buckets, int first_parameter, int second_parameter,
-                  int prime_number = PRIME_NUMBER) {
-  int64_t temp_value = static_cast<int64_t>(number) % (prime_number) *
-      static_cast<int64_t>(first_parameter);
-  temp_value += second_parameter;
-  temp_value = (temp_value % prime_number) % number_of_buckets;
-  if (temp_value < 0) {
-    return temp_value + number_of_buckets;
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::Initialize(const std::vector<T> &numbers,
+                                           const BuildOptions& options) {
+  steady_timer timer;
+  build_statistics = BuildStatistics();
+  uint64_t seed;
+  if (options.seed) {
+    seed = *options.seed;
   } else {
-    return temp_value;
+    std::random_device rand_dev;
+    seed = (static_cast<uint64_t>(rand_dev()) << 32) | rand_dev();
   }
-}
+  SplitMix64 generator(seed);
+  mapped_snapshot.reset();
+  owned_buckets.assign(numbers.size(), BucketType());
+  owned_keys.clear();
+  AttachOwnedStorage();
+  if (numbers.empty()) {
+    return;
+  }
+  uint32_t number_of_buckets = numbers.size();
+  std::vector<uint32_t> front_hashes(numbers.size());
+  std::vector<std::atomic<uint32_t>> bucket_sizes(numbers.size());
+  int64_t sum_of_squares;
 
-void FixedSet::Initialize(const std::vector<int> &numbers) {
-  std::random_device rand_dev;
-  std::mt19937 generator(rand_dev());
-  std::uniform_int_distribution<int> gen_uniform_unit_for_first_parameter(1, PRIME_NUMBER - 1);
-  std::uniform_int_distribution<int> gen_uniform_unit_for_second_parameter(0, PRIME_NUMBER - 1);
-  bool memory_size = false;
-  int first_parameter;
-  int second_parameter;
-  std::vector<std::vector<int>> front_buckets(numbers.size());
+  do {
+    ++build_statistics.first_level_attempts;
+    front_hash_parameters = HashFunction::Generate(generator);
+    ParallelFor(numbers.size(), options.threads_count, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        bucket_sizes[i].store(0, std::memory_order_relaxed);
+      }
+    });
+    ParallelFor(numbers.size(), options.threads_count, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        front_hashes[i] = HashFunction::Hash(numbers[i], front_hash_parameters,
+                                             number_of_buckets);
+        bucket_sizes[front_hashes[i]].fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+    std::atomic<int64_t> total_sum_of_squares(0);
+    ParallelFor(numbers.size(), options.threads_count, [&](size_t begin, size_t end) {
+      int64_t partial_sum = 0;
+      for (size_t i = begin; i < end; ++i) {
+        int64_t size = bucket_sizes[i].load(std::memory_order_relaxed);
+        partial_sum += size * size;
+      }
+      total_sum_of_squares += partial_sum;
+    });
+    sum_of_squares = total_sum_of_squares;
+  } while (sum_of_squares > 4 * static_cast<int64_t>(numbers.size()));
 
-  while (memory_size == false) {
-    first_parameter = gen_uniform_unit_for_first_parameter(generator);
-    second_parameter = gen_uniform_unit_for_second_parameter(generator);
-    for (auto &number: numbers) {
-      front_buckets[hash_function(number, numbers.size(), first_parameter,
-                                  second_parameter)].push_back(number);
+  std::vector<uint32_t> bucket_begins(numbers.size() + 1);
+  uint32_t partition_offset = 0;
+  uint32_t table_offset = 0;
+  for (uint32_t number_of_bucket = 0; number_of_bucket < number_of_buckets; ++number_of_bucket) {
+    uint32_t size = bucket_sizes[number_of_bucket].load(std::memory_order_relaxed);
+    bucket_begins[number_of_bucket] = partition_offset;
+    bucket_sizes[number_of_bucket].store(partition_offset, std::memory_order_relaxed);
+    owned_buckets[number_of_bucket] = BucketType(table_offset, size * size);
+    partition_offset += size;
+    table_offset += size * size;
+  }
+  bucket_begins[number_of_buckets] = partition_offset;
+  std::vector<T> partitioned_keys(numbers.size());
+  ParallelFor(numbers.size(), options.threads_count, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      auto position = bucket_sizes[front_hashes[i]].fetch_add(1, std::memory_order_relaxed);
+      partitioned_keys[position] = numbers[i];
     }
-    int64_t sum_of_squares = 0;
-    for (auto &bucket: front_buckets) {
-      sum_of_squares += bucket.size() * bucket.size();
+  });
+  build_statistics.partition.seconds = timer.seconds_elapsed();
+  build_statistics.partition.memory_bytes =
+      front_hashes.size() * sizeof(uint32_t) +
+      bucket_sizes.size() * sizeof(std::atomic<uint32_t>) +
+      bucket_begins.size() * sizeof(uint32_t) + partitioned_keys.size() * sizeof(T) +
+      owned_buckets.size() * sizeof(BucketType);
+  std::vector<uint32_t>().swap(front_hashes);
+  std::vector<std::atomic<uint32_t>>().swap(bucket_sizes);
+
+  timer.reset();
+  owned_keys.resize(sum_of_squares);
+  ParallelFor(numbers.size(), options.threads_count, [&](size_t begin, size_t end) {
+    for (size_t number_of_bucket = begin; number_of_bucket < end; ++number_of_bucket) {
+      uint32_t bucket_size = bucket_begins[number_of_bucket + 1] - bucket_begins[number_of_bucket];
+      if (bucket_size > 0) {
+        BuildBucket(&partitioned_keys[bucket_begins[number_of_bucket]], bucket_size, seed,
+                    number_of_bucket);
+      }
     }
-    if (sum_of_squares <= 4 * numbers.size()) {
-      memory_size = true;
-    } else {
-      for (int i = 0 ; i < front_buckets.size(); ++i) {
-        front_buckets[i].clear();
+  });
+  build_statistics.second_level.seconds = timer.seconds_elapsed();
+  build_statistics.second_level.memory_bytes =
+      bucket_begins.size() * sizeof(uint32_t) + partitioned_keys.size() * sizeof(T) +
+      owned_buckets.size() * sizeof(BucketType) + owned_keys.size() * sizeof(T);
+  AttachOwnedStorage();
+}
+
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::BuildBucket(const T* bucket_keys, uint32_t bucket_size,
+                                            uint64_t seed, size_t number_of_bucket) {
+  SplitMix64 generator(seed ^ (number_of_bucket + 1) * 0xD6E8FEB86659FD93ULL);
+  BucketType &bucket = owned_buckets[number_of_bucket];
+  auto table = owned_keys.begin() + bucket.offset;
+  std::vector<uint8_t> occupied(bucket.size);
+  bool unique_hashes = false;
+  while (unique_hashes == false) {
+    bucket.hash_parameters = HashFunction::Generate(generator);
+    std::fill(occupied.begin(), occupied.end(), 0);
+    unique_hashes = true;
+    for (uint32_t i = 0; i < bucket_size; ++i) {
+      auto hash_value = HashFunction::Hash(bucket_keys[i], bucket.hash_parameters, bucket.size);
+      if (occupied[hash_value]) {
+        unique_hashes = false;
+        break;
       }
+      occupied[hash_value] = 1;
+      table[hash_value] = bucket_keys[i];
     }
   }
-  front_first_hash_function_parameter = first_parameter;
-  front_second_hash_function_parameter = second_parameter;
-  this->front_buckets.assign(numbers.size(), false);
-  hash_table.assign(numbers.size(), Bucket());
-
-  for (int i = 0 ; i < numbers.size(); ++i) {
-    if (front_buckets[i].size() > 0) {
-      this->front_buckets[i] = true;
+  const T& filler = table[std::find(occupied.begin(), occupied.end(), 1) - occupied.begin()];
+  for (uint32_t i = 0; i < bucket.size; ++i) {
+    if (!occupied[i]) {
+      table[i] = filler;
     }
   }
+}
 
-  for (int number_of_bucket = 0; number_of_bucket < front_buckets.size(); ++number_of_bucket) {
-    if (front_buckets[number_of_bucket].size() > 0) {
-      bool unique_hashes = false;
-      auto bucket = front_buckets[number_of_bucket];
-      while (unique_hashes == false) {
-        first_parameter = gen_uniform_unit_for_first_parameter(generator);
-        second_parameter = gen_uniform_unit_for_second_parameter(generator);
-        std::vector<int> hashed_bucket_keys(bucket.size() * bucket.size(), NAN_VALUE);
-        bool success = true;
-        for (int i = 0; i < bucket.size(); ++i) {
-          auto hash_value = hash_function(bucket[i], bucket.size() * bucket.size(),
-                                          first_parameter, second_parameter);
-          if (hashed_bucket_keys[hash_value] != NAN_VALUE) {
-            success = false;
-            break;
-          } else {
-            hashed_bucket_keys[hash_value] = bucket[i];
-          }
-        }
-        if (success) {
-          unique_hashes = true;
-          this->hash_table[number_of_bucket] = Bucket(first_parameter, second_parameter,
-                                                      hashed_bucket_keys);
-        }
-      }
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::AttachOwnedStorage() {
+  buckets = owned_buckets.data();
+  buckets_count = owned_buckets.size();
+  keys = owned_keys.data();
+  keys_count = owned_keys.size();
+}
+
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::Save(const std::string& path) const {
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  WriteSnapshot(stream);
+  if (!stream) {
+    throw std::runtime_error("Cannot write snapshot to " + path);
+  }
+}
+
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::WriteSnapshot(std::ostream& stream) const {
+  SnapshotHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.key_size = sizeof(T);
+  header.hash_family = HashFunction::ID;
+  header.bucket_size = sizeof(BucketType);
+  header.buckets_count = buckets_count;
+  header.keys_count = keys_count;
+  std::memcpy(header.front_hash_parameters, &front_hash_parameters, sizeof(HashParameters));
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  stream.write(reinterpret_cast<const char*>(buckets), buckets_count * sizeof(BucketType));
+  stream.write(reinterpret_cast<const char*>(keys), keys_count * sizeof(T));
+}
+
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::Open(const std::string& path) {
+  auto snapshot = std::make_unique<MappedFile>(path);
+  if (snapshot->size() < sizeof(SnapshotHeader)) {
+    throw std::runtime_error("Snapshot " + path + " is truncated");
+  }
+  const auto* header = reinterpret_cast<const SnapshotHeader*>(snapshot->data());
+  if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+    throw std::runtime_error(path + " is not a FixedSet snapshot");
+  }
+  if (header->version != SNAPSHOT_VERSION) {
+    throw std::runtime_error("Unsupported snapshot version " + std::to_string(header->version));
+  }
+  if (header->key_size != sizeof(T) || header->hash_family != HashFunction::ID ||
+      header->bucket_size != sizeof(BucketType)) {
+    throw std::runtime_error("Snapshot " + path + " was built for another key type or hash");
+  }
+  uint64_t payload_size = snapshot->size() - sizeof(SnapshotHeader);
+  if (header->buckets_count > std::numeric_limits<uint32_t>::max() ||
+      header->buckets_count > payload_size / sizeof(BucketType)) {
+    throw std::runtime_error("Snapshot " + path + " has inconsistent size");
+  }
+  uint64_t keys_size = payload_size - header->buckets_count * sizeof(BucketType);
+  if (keys_size % sizeof(T) != 0 || header->keys_count != keys_size / sizeof(T)) {
+    throw std::runtime_error("Snapshot " + path + " has inconsistent size");
+  }
+  const auto* snapshot_buckets =
+      reinterpret_cast<const BucketType*>(snapshot->data() + sizeof(SnapshotHeader));
+  for (uint64_t i = 0; i < header->buckets_count; ++i) {
+    if (static_cast<uint64_t>(snapshot_buckets[i].offset) + snapshot_buckets[i].size >
+        header->keys_count) {
+      throw std::runtime_error("Snapshot " + path + " has bucket " + std::to_string(i) +
+                               " outside of the key array");
     }
   }
+  owned_buckets.clear();
+  owned_keys.clear();
+  build_statistics = BuildStatistics();
+  std::memcpy(&front_hash_parameters, header->front_hash_parameters, sizeof(HashParameters));
+  buckets = snapshot_buckets;
+  buckets_count = header->buckets_count;
+  keys = reinterpret_cast<const T*>(snapshot->data() + sizeof(SnapshotHeader) +
+                                    buckets_count * sizeof(BucketType));
+  keys_count = header->keys_count;
+  mapped_snapshot = std::move(snapshot);
 }
 
-bool FixedSet::Contains(int number) const {
-  auto front_buckets = this->GetFrontBuckets();
-  auto front_hash_value = hash_function(number, front_buckets.size(),
-                                        this->GetFrontFirstHashParameter(),
-                                        this->GetFrontSecondHashParameter());
-  if (!front_buckets[front_hash_value]) {
+template <class T, class HashFunction>
+bool FixedSet<T, HashFunction>::Contains(const T& number) const {
+  if (buckets_count == 0) {
+    return false;
+  }
+  auto front_hash_value = HashFunction::Hash(number, front_hash_parameters, buckets_count);
+  const BucketType &bucket = buckets[front_hash_value];
+  if (bucket.size == 0) {
     return false;
   }
-  auto front_bucket = this->GetHashTable()[front_hash_value];
-  auto bucket_hash_value = hash_function(number, front_bucket.hashed_keys.size(),
-                                         front_bucket.first_hash_parameter,
-                                         front_bucket.second_hash_parameter);
-  if (front_bucket.hashed_keys[bucket_hash_value] == number) {
-    return true;
+  auto bucket_hash_value = HashFunction::Hash(number, bucket.hash_parameters, bucket.size);
+  return keys[bucket.offset + bucket_hash_value] == number;
+}
+
+/*
+ * Запросы обрабатываются пачками по BATCH_SIZE ключей в три прохода:
+ * сначала считаются хеши первого уровня и запрашиваются заголовки бакетов,
+ * затем хеши второго уровня и ячейки с ключами, и лишь потом ключи
+ * сравниваются. Так промахи кеша для разных ключей пачки перекрываются.
+ */
+
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::ContainsBatch(const T* numbers, size_t count,
+                                              uint8_t* answers) const {
+  if (buckets_count == 0) {
+    std::fill(answers, answers + count, 0);
+    return;
+  }
+  if constexpr (VECTOR_HASHING) {
+    ContainsBatchVectorized(numbers, count, answers);
+    return;
+  }
+  const BucketType* batch_buckets[BATCH_SIZE];
+  int64_t key_positions[BATCH_SIZE];
+  for (size_t begin = 0; begin < count; begin += BATCH_SIZE) {
+    size_t batch_size = std::min(BATCH_SIZE, count - begin);
+    for (size_t i = 0; i < batch_size; ++i) {
+      batch_buckets[i] = &buckets[HashFunction::Hash(numbers[begin + i], front_hash_parameters,
+                                                     buckets_count)];
+      __builtin_prefetch(batch_buckets[i]);
+    }
+    for (size_t i = 0; i < batch_size; ++i) {
+      const BucketType &bucket = *batch_buckets[i];
+      if (bucket.size == 0) {
+        key_positions[i] = -1;
+        continue;
+      }
+      key_positions[i] = bucket.offset + HashFunction::Hash(numbers[begin + i],
+                                                            bucket.hash_parameters, bucket.size);
+      __builtin_prefetch(&keys[key_positions[i]]);
+    }
+    for (size_t i = 0; i < batch_size; ++i) {
+      answers[begin + i] = key_positions[i] >= 0 &&
+          keys[key_positions[i]] == numbers[begin + i];
+    }
+  }
+}
+
+/*
+ * Тот же ContainsBatch, но хеши обоих уровней для пачки считают
+ * векторные ядра multiply-shift. Хвост пачки дополняется нулями.
+ * Проходы идут конвейером со сдвигом на пачку: пока для пачки b + 2
+ * считаются хеши первого уровня, для b + 1 — хеши второго, а в b
+ * сравниваются ключи, так что между prefetch и чтением проходит целая
+ * пачка работы.
+ */
+
+template <class T, class HashFunction>
+void FixedSet<T, HashFunction>::ContainsBatchVectorized(const T* numbers, size_t count,
+                                                        uint8_t* answers) const {
+  constexpr size_t STAGES = 3;
+  const auto &kernels = MultiplyShiftKernels<BucketType>::Get();
+  uint32_t hashes[BATCH_SIZE];
+  uint32_t padded_chunks[STAGES][BATCH_SIZE];
+  const uint32_t* chunks[STAGES];
+  const BucketType* batch_buckets[STAGES][BATCH_SIZE];
+  int64_t key_positions[STAGES][BATCH_SIZE];
+  size_t batches_count = (count + BATCH_SIZE - 1) / BATCH_SIZE;
+  for (size_t batch = 0; batch < batches_count + STAGES - 1; ++batch) {
+    if (batch < batches_count) {
+      size_t begin = batch * BATCH_SIZE;
+      size_t batch_size = std::min(BATCH_SIZE, count - begin);
+      size_t stage = batch % STAGES;
+      if (sizeof(T) == sizeof(uint32_t) && batch_size == BATCH_SIZE) {
+        chunks[stage] = reinterpret_cast<const uint32_t*>(numbers + begin);
+      } else {
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+          padded_chunks[stage][i] = i < batch_size ? KeyChunks<T>::Get(numbers[begin + i], 0) : 0;
+        }
+        chunks[stage] = padded_chunks[stage];
+      }
+      kernels.front(chunks[stage], front_hash_parameters, buckets_count, hashes, BATCH_SIZE);
+      for (size_t i = 0; i < BATCH_SIZE; ++i) {
+        batch_buckets[stage][i] = &buckets[hashes[i]];
+        __builtin_prefetch(batch_buckets[stage][i]);
+      }
+    }
+    if (batch >= 1 && batch - 1 < batches_count) {
+      size_t begin = (batch - 1) * BATCH_SIZE;
+      size_t batch_size = std::min(BATCH_SIZE, count - begin);
+      size_t stage = (batch - 1) % STAGES;
+      kernels.in_buckets(chunks[stage], batch_buckets[stage], hashes, BATCH_SIZE);
+      for (size_t i = 0; i < batch_size; ++i) {
+        const BucketType &bucket = *batch_buckets[stage][i];
+        if (bucket.size == 0) {
+          key_positions[stage][i] = -1;
+          continue;
+        }
+        key_positions[stage][i] = bucket.offset + hashes[i];
+        __builtin_prefetch(&keys[key_positions[stage][i]]);
+      }
+    }
+    if (batch >= 2) {
+      size_t begin = (batch - 2) * BATCH_SIZE;
+      size_t batch_size = std::min(BATCH_SIZE, count - begin);
+      const auto &positions = key_positions[(batch - 2) % STAGES];
+      for (size_t i = 0; i < batch_size; ++i) {
+        answers[begin + i] = positions[i] >= 0 && keys[positions[i]] == numbers[begin + i];
+      }
+    }
   }
-  return false;
 }
 
 
-std::vector<int> ReadNumbers() {
-  int size_of_numbers;
-  std::cin >> size_of_numbers;
+std::vector<int> ReadNumbers(FastReader& reader) {
+  int size_of_numbers = reader.ReadInteger();
   std::vector<int> keys(size_of_numbers);
   for (int i = 0 ; i < size_of_numbers; ++i) {
-    std::cin >> keys[i];
+    keys[i] = reader.ReadInteger();
   }
   return keys;
 }
 
-std::vector<int> ReadQueries(int number_of_queries) {
+std::vector<int> ReadQueries(FastReader& reader, int number_of_queries) {
   std::vector<int> queries(number_of_queries);
   for (auto &query: queries) {
-    std::cin >> query;
+    query = reader.ReadInteger();
   }
   return queries;
 }
 
-std::vector<bool> GetQueriesAnswers(const std::vector<int>& queries, const FixedSet& set) {
-  std::vector<bool> answers;
-  answers.reserve(queries.size());
-  for (const auto &number: queries) {
-    answers.push_back(set.Contains(number));
-  }
+template <class Set>
+std::vector<uint8_t> GetQueriesAnswers(const std::vector<int>& queries, const Set& set) {
+  std::vector<uint8_t> answers(queries.size());
+  set.ContainsBatch(queries.data(), queries.size(), answers.data());
   return answers;
 }
 
-void WriteAnswers(const std::vector<bool>& answers) {
+void WriteAnswers(const std::vector<uint8_t>& answers, FastWriter& writer) {
   for (auto answer: answers) {
-    answer ? std::cout << "Yes\n" : std::cout << "No\n";
+    answer ? writer.WriteString("Yes\n", 4) : writer.WriteString("No\n", 3);
+  }
+}
+
+/*
+ * Самопроверка (--self-test). Каждое поддерживаемое процессором ядро
+ * multiply-shift сверяется со скалярным на случайных данных, а
+ * ContainsBatch — с Contains и с заранее известным ответом, для ключей
+ * int, int64_t и FixedString<12> (последние хешируются по нескольким
+ * кускам и идут мимо векторных ядер). Ключи получаются из различных
+ * номеров инъективным отображением MakeTestKey; в множестве лежат ключи
+ * с чётными номерами, запросы берутся вперемешку.
+ */
+
+void MakeTestKey(uint64_t id, int& key) {
+  key = static_cast<int>(static_cast<uint32_t>(id) * 0x9E3779B1u);
+}
+
+void MakeTestKey(uint64_t id, int64_t& key) {
+  key = static_cast<int64_t>(id * 0x9E3779B97F4A7C15ULL);
+}
+
+template <size_t Length>
+void MakeTestKey(uint64_t id, FixedString<Length>& key) {
+  static_assert(Length >= sizeof(id), "Test key must hold the whole id");
+  key.data.fill('x');
+  std::memcpy(key.data.data(), &id, sizeof(id));
+}
+
+void CheckMultiplyShiftKernels(FastWriter& writer) {
+  using Kernels = MultiplyShiftKernels<Bucket<MultiplyShiftHash<int>::Parameters>>;
+  using BucketType = Bucket<MultiplyShiftHash<int>::Parameters>;
+  constexpr size_t COUNT = 1 << 12;
+  SplitMix64 generator(1);
+  std::vector<uint32_t> chunks(COUNT);
+  std::vector<BucketType> buckets(COUNT);
+  std::vector<const BucketType*> bucket_pointers(COUNT);
+  for (size_t i = 0; i < COUNT; ++i) {
+    chunks[i] = generator();
+    buckets[i].size = i % 3 == 0 ? 0 : generator() >> (generator() % 64);
+    buckets[i].hash_parameters = MultiplyShiftHash<int>::Generate(generator);
+    bucket_pointers[i] = &buckets[i];
+  }
+  auto front_parameters = MultiplyShiftHash<int>::Generate(generator);
+  uint32_t front_table_size = generator();
+  std::vector<uint32_t> expected_front(COUNT);
+  std::vector<uint32_t> expected_in_buckets(COUNT);
+  for (size_t i = 0; i < COUNT; ++i) {
+    int key = static_cast<int>(chunks[i]);
+    expected_front[i] = MultiplyShiftHash<int>::Hash(key, front_parameters, front_table_size);
+    expected_in_buckets[i] = MultiplyShiftHash<int>::Hash(key, buckets[i].hash_parameters,
+                                                          buckets[i].size);
+  }
+  std::vector<uint32_t> hashes(COUNT);
+  for (const auto &kernels: Kernels::GetSupported()) {
+    kernels.front(chunks.data(), front_parameters, front_table_size, hashes.data(), COUNT);
+    bool front_ok = hashes == expected_front;
+    kernels.in_buckets(chunks.data(), bucket_pointers.data(), hashes.data(), COUNT);
+    if (!front_ok || hashes != expected_in_buckets) {
+      throw std::runtime_error(std::string("multiply-shift kernel ") + kernels.name +
+                               " disagrees with MultiplyShiftHash::Hash");
+    }
+    writer.WriteFormatted("multiply-shift kernel %s: ok\n", kernels.name);
+  }
+}
+
+template <class T, class HashFunction>
+void CheckContainsBatch(const char* name, FastWriter& writer) {
+  constexpr size_t KEYS_COUNT = 50000;
+  constexpr size_t QUERIES_COUNT = 4 * KEYS_COUNT + 3;
+  std::vector<T> keys(KEYS_COUNT);
+  for (size_t i = 0; i < KEYS_COUNT; ++i) {
+    MakeTestKey(2 * i, keys[i]);
+  }
+  BuildOptions build_options;
+  build_options.seed = 12345;
+  FixedSet<T, HashFunction> set;
+  set.Initialize(keys, build_options);
+  SplitMix64 generator(2);
+  std::vector<T> queries(QUERIES_COUNT);
+  std::vector<uint8_t> expected(QUERIES_COUNT);
+  for (size_t i = 0; i < QUERIES_COUNT; ++i) {
+    uint64_t id = generator() % (4 * KEYS_COUNT);
+    MakeTestKey(id, queries[i]);
+    expected[i] = id % 2 == 0 && id / 2 < KEYS_COUNT;
+  }
+  std::vector<uint8_t> answers(QUERIES_COUNT);
+  set.ContainsBatch(queries.data(), queries.size(), answers.data());
+  for (size_t i = 0; i < QUERIES_COUNT; ++i) {
+    if (answers[i] != expected[i] || set.Contains(queries[i]) != static_cast<bool>(expected[i])) {
+      throw std::runtime_error(std::string("FixedSet<") + name + "> answers query " +
+                               std::to_string(i) + " incorrectly");
+    }
+  }
+  writer.WriteFormatted("FixedSet<%s>: ok\n", name);
+}
+
+/*
+ * Снимки, построенные с одним seed при разном числе потоков, должны
+ * совпадать побайтно.
+ */
+template <class T, class HashFunction>
+void CheckReproducibleBuild(const char* name, FastWriter& writer) {
+  constexpr size_t KEYS_COUNT = 200000;
+  std::vector<T> keys(KEYS_COUNT);
+  for (size_t i = 0; i < KEYS_COUNT; ++i) {
+    MakeTestKey(i, keys[i]);
+  }
+  std::string reference;
+  for (unsigned threads_count: {1u, 2u, 8u, 16u}) {
+    BuildOptions build_options;
+    build_options.seed = 42;
+    build_options.threads_count = threads_count;
+    FixedSet<T, HashFunction> set;
+    set.Initialize(keys, build_options);
+    std::ostringstream stream;
+    set.WriteSnapshot(stream);
+    if (threads_count == 1) {
+      reference = stream.str();
+    } else if (stream.str() != reference) {
+      throw std::runtime_error(std::string("FixedSet<") + name + "> snapshot built with " +
+                               std::to_string(threads_count) + " threads differs");
+    }
+  }
+  writer.WriteFormatted("FixedSet<%s> snapshot: same for 1-16 threads\n", name);
+}
+
+const char* BatchHashingName() {
+  return MultiplyShiftKernels<Bucket<MultiplyShiftHash<int>::Parameters>>::Get().name;
+}
+
+void RunSelfTest(FastWriter& writer) {
+  writer.WriteFormatted("batch hashing: %s\n", BatchHashingName());
+  CheckMultiplyShiftKernels(writer);
+  CheckContainsBatch<int, MultiplyShiftHash<int>>("int, multiply-shift", writer);
+  CheckContainsBatch<int, ModPrimeHash<int>>("int, mod-prime", writer);
+  CheckContainsBatch<int, TabulationHash<int>>("int, tabulation", writer);
+  CheckContainsBatch<int64_t, MultiplyShiftHash<int64_t>>("int64, multiply-shift", writer);
+  CheckContainsBatch<int64_t, TabulationHash<int64_t>>("int64, tabulation", writer);
+  CheckContainsBatch<FixedString<12>, MultiplyShiftHash<FixedString<12>>>(
+      "string12, multiply-shift", writer);
+  CheckContainsBatch<FixedString<12>, ModPrimeHash<FixedString<12>>>(
+      "string12, mod-prime", writer);
+  CheckReproducibleBuild<int, MultiplyShiftHash<int>>("int, multiply-shift", writer);
+  CheckReproducibleBuild<FixedString<12>, TabulationHash<FixedString<12>>>(
+      "string12, tabulation", writer);
+}
+
+/*
+ * Прежняя раскладка таблицы для сравнения в --bench: у каждого бакета
+ * свой std::vector ключей, признаки непустых бакетов — std::vector<bool>,
+ * а Contains, как и раньше, копирует их по значению на каждый запрос.
+ * Хеш-функция та же, что была: (a * x + b) mod p mod size.
+ */
+class ByValueBucketFixedSet {
+ public:
+  void Initialize(const std::vector<int>& numbers, uint64_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> first_parameters(1, LEGACY_PRIME - 1);
+    std::uniform_int_distribution<int> second_parameters(0, LEGACY_PRIME - 1);
+    std::vector<std::vector<int>> partition(numbers.size());
+    int64_t sum_of_squares;
+    do {
+      for (auto &bucket: partition) {
+        bucket.clear();
+      }
+      front_first_parameter_ = first_parameters(generator);
+      front_second_parameter_ = second_parameters(generator);
+      for (int number: numbers) {
+        partition[Hash(number, numbers.size(), front_first_parameter_,
+                       front_second_parameter_)].push_back(number);
+      }
+      sum_of_squares = 0;
+      for (const auto &bucket: partition) {
+        sum_of_squares += bucket.size() * bucket.size();
+      }
+    } while (sum_of_squares > 4 * static_cast<int64_t>(numbers.size()));
+    front_buckets_.assign(numbers.size(), false);
+    hash_table_.assign(numbers.size(), Bucket());
+    for (size_t number_of_bucket = 0; number_of_bucket < partition.size(); ++number_of_bucket) {
+      const auto &bucket_keys = partition[number_of_bucket];
+      if (bucket_keys.empty()) {
+        continue;
+      }
+      front_buckets_[number_of_bucket] = true;
+      Bucket &bucket = hash_table_[number_of_bucket];
+      bool unique_hashes = false;
+      while (!unique_hashes) {
+        bucket.first_parameter = first_parameters(generator);
+        bucket.second_parameter = second_parameters(generator);
+        bucket.hashed_keys.assign(bucket_keys.size() * bucket_keys.size(), LEGACY_EMPTY_KEY);
+        unique_hashes = true;
+        for (int number: bucket_keys) {
+          auto &slot = bucket.hashed_keys[Hash(number, bucket.hashed_keys.size(),
+                                               bucket.first_parameter, bucket.second_parameter)];
+          if (slot != LEGACY_EMPTY_KEY) {
+            unique_hashes = false;
+            break;
+          }
+          slot = number;
+        }
+      }
+    }
+  }
+
+  bool Contains(int number) const {
+    auto front_buckets = front_buckets_;
+    auto front_hash_value = Hash(number, front_buckets.size(), front_first_parameter_,
+                                 front_second_parameter_);
+    if (!front_buckets[front_hash_value]) {
+      return false;
+    }
+    auto bucket = hash_table_[front_hash_value];
+    auto bucket_hash_value = Hash(number, bucket.hashed_keys.size(), bucket.first_parameter,
+                                  bucket.second_parameter);
+    return bucket.hashed_keys[bucket_hash_value] == number;
+  }
+
+ private:
+  static constexpr int64_t LEGACY_PRIME = 2147483323;
+  static constexpr int LEGACY_EMPTY_KEY = 1000000001;
+
+  struct Bucket {
+    int first_parameter = 0;
+    int second_parameter = 0;
+    std::vector<int> hashed_keys;
+  };
+
+  std::vector<Bucket> hash_table_;
+  std::vector<bool> front_buckets_;
+  int front_first_parameter_ = 0;
+  int front_second_parameter_ = 0;
+
+  static size_t Hash(int number, size_t table_size, int first_parameter, int second_parameter) {
+    int64_t value = static_cast<int64_t>(number) % LEGACY_PRIME * first_parameter;
+    value = (value + second_parameter) % LEGACY_PRIME % static_cast<int64_t>(table_size);
+    return value < 0 ? value + table_size : value;
+  }
+};
+
+/*
+ * Микробенчмарк поиска (--bench): одни и те же ключи и запросы (половина
+ * запросов попадает в множество) проверяются в прежней раскладке и в
+ * плоской, одиночными Contains и пакетами. Число найденных ключей у всех
+ * вариантов должно совпасть.
+ */
+void WriteBenchmark(FastWriter& writer) {
+  SplitMix64 generator(3);
+  std::vector<int> keys(BENCHMARK_KEYS_COUNT);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    MakeTestKey(2 * i, keys[i]);
+  }
+  std::vector<int> queries(BENCHMARK_QUERIES_COUNT);
+  for (auto &query: queries) {
+    MakeTestKey(generator() % (4 * keys.size()), query);
+  }
+  writer.WriteFormatted("%zu keys, %zu queries\n", keys.size(), queries.size());
+  auto measure = [&](const char* name, auto count_found) {
+    steady_timer timer;
+    size_t found = count_found();
+    writer.WriteFormatted("%s: %.2f ns per lookup, %zu found\n", name,
+                          timer.seconds_elapsed() * 1e9 / queries.size(), found);
+  };
+  ByValueBucketFixedSet by_value_set;
+  by_value_set.Initialize(keys, 1);
+  measure("by-value buckets, Contains", [&]() {
+    size_t found = 0;
+    for (int query: queries) {
+      found += by_value_set.Contains(query);
+    }
+    return found;
+  });
+  BuildOptions build_options;
+  build_options.seed = 1;
+  auto measure_flat = [&](const char* contains_name, const char* batch_name, auto& set) {
+    set.Initialize(keys, build_options);
+    measure(contains_name, [&]() {
+      size_t found = 0;
+      for (int query: queries) {
+        found += set.Contains(query);
+      }
+      return found;
+    });
+    measure(batch_name, [&]() {
+      std::vector<uint8_t> answers(queries.size());
+      set.ContainsBatch(queries.data(), queries.size(), answers.data());
+      return static_cast<size_t>(std::count(answers.begin(), answers.end(), 1));
+    });
+  };
+  FixedSet<int, ModPrimeHash<int>> mod_prime_set;
+  measure_flat("flat, mod-prime, Contains", "flat, mod-prime, ContainsBatch", mod_prime_set);
+  FixedSet<int, MultiplyShiftHash<int>> multiply_shift_set;
+  measure_flat("flat, multiply-shift, Contains", "flat, multiply-shift, ContainsBatch",
+               multiply_shift_set);
+}
+
+/*
+ * С --load PATH таблица не строится, а открывается из снимка, и на вход
+ * подаются только запросы: их число и сами запросы. С --save PATH
+ * построенная таблица дополнительно сохраняется в снимок. --hash выбирает
+ * семейство хеш-функций, а --stats печатает в stderr время и память фаз
+ * построения и время ответа на запросы, что позволяет сравнивать семейства.
+ * --self-test сверяет пакетные запросы с одиночными и выходит, а --bench
+ * сравнивает скорость поиска в прежней и плоской раскладках.
+ */
+
+struct ProgramOptions {
+  BuildOptions build_options;
+  bool print_statistics = false;
+  std::string save_path;
+  std::string load_path;
+  std::string hash_family = "multiply-shift";
+  bool self_test = false;
+  bool benchmark = false;
+};
+
+ProgramOptions ParseProgramOptions(int argc, char* argv[]) {
+  ProgramOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string option = argv[i];
+    if (option == "--stats") {
+      options.print_statistics = true;
+    } else if (option == "--self-test") {
+      options.self_test = true;
+    } else if (option == "--bench") {
+      options.benchmark = true;
+    } else if (option == "--seed" && i + 1 < argc) {
+      options.build_options.seed = std::stoull(argv[++i]);
+    } else if (option == "--save" && i + 1 < argc) {
+      options.save_path = argv[++i];
+    } else if (option == "--load" && i + 1 < argc) {
+      options.load_path = argv[++i];
+    } else if (option == "--hash" && i + 1 < argc) {
+      options.hash_family = argv[++i];
+    } else if (option == "--threads" && i + 1 < argc) {
+      options.build_options.threads_count = std::max(1ul, std::stoul(argv[++i]));
+    } else {
+      throw std::invalid_argument("Unknown option " + option);
+    }
   }
+  return options;
+}
+
+void WriteBuildStatistics(const BuildStatistics& statistics, std::ostream& stream = std::cerr) {
+  stream << "first level attempts: " << statistics.first_level_attempts << "\n";
+  stream << "partition: " << statistics.partition.seconds << " s, "
+         << statistics.partition.memory_bytes << " bytes\n";
+  stream << "second level: " << statistics.second_level.seconds << " s, "
+         << statistics.second_level.memory_bytes << " bytes\n";
 }
 
-int main() {
-  std::ios_base::sync_with_stdio(false);
-  auto numbers = ReadNumbers();
-  int number_of_queries;
-  std::cin >> number_of_queries;
-  auto queries = ReadQueries(number_of_queries);
-  FixedSet set;
-  set.Initialize(numbers);
+template <class HashFunction>
+void RunFixedSet(const ProgramOptions& options, FastReader& reader, FastWriter& writer) {
+  FixedSet<int, HashFunction> set;
+  if (!options.load_path.empty()) {
+    set.Open(options.load_path);
+  } else {
+    auto numbers = ReadNumbers(reader);
+    set.Initialize(numbers, options.build_options);
+    if (options.print_statistics) {
+      WriteBuildStatistics(set.GetBuildStatistics());
+    }
+  }
+  if (!options.save_path.empty()) {
+    set.Save(options.save_path);
+  }
+  int number_of_queries = reader.ReadInteger();
+  auto queries = ReadQueries(reader, number_of_queries);
+  steady_timer timer;
   auto answers = GetQueriesAnswers(queries, set);
-  WriteAnswers(answers);
+  if (options.print_statistics) {
+    std::cerr << "lookup: " << timer.seconds_elapsed() << " s, batch hashing "
+              << BatchHashingName() << "\n";
+  }
+  WriteAnswers(answers, writer);
+}
+
+int main(int argc, char* argv[]) {
+  auto options = ParseProgramOptions(argc, argv);
+  FastReader reader;
+  FastWriter writer;
+  if (options.self_test) {
+    RunSelfTest(writer);
+    return 0;
+  }
+  if (options.benchmark) {
+    WriteBenchmark(writer);
+    return 0;
+  }
+  if (options.hash_family == "mod-prime") {
+    RunFixedSet<ModPrimeHash<int>>(options, reader, writer);
+  } else if (options.hash_family == "multiply-shift") {
+    RunFixedSet<MultiplyShiftHash<int>>(options, reader, writer);
+  } else if (options.hash_family == "tabulation") {
+    RunFixedSet<TabulationHash<int>>(options, reader, writer);
+  } else {
+    throw std::invalid_argument("Unknown hash family " + options.hash_family);
+  }
 }
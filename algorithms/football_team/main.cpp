@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <functional>
 
+#include "../common/fast_io.h"
+
 struct Player {
   int number;
   int efficiency;
@@ -30,14 +32,12 @@ struct ComparePlayersNumber {
   }
 };
 
-std::vector<Player> ReadPlayers(std::istream &input_stream = std::cin) {
-  int size;
-  input_stream >> size;
+std::vector<Player> ReadPlayers(FastReader &reader) {
+  int size = reader.ReadInteger();
   std::vector<Player> team;
   team.reserve(size);
   for (int number = 0; number < size; ++number) {
-    int cur_efficiency;
-    input_stream >> cur_efficiency;
+    int cur_efficiency = reader.ReadInteger();
     team.emplace_back(number + 1, cur_efficiency);
   }
   return team;
@@ -118,20 +118,23 @@ int64_t CountSummaryEfficiency(const std::vector<Player> &team) {
   return summary_efficiency;
 }
 
-void WriteTeam(const std::vector<Player> &team, std::ostream &output_stream = std::cout) {
+void WriteTeam(const std::vector<Player> &team, FastWriter &writer) {
   auto summary_efficiency = CountSummaryEfficiency(team);
-  output_stream << summary_efficiency << "\n";
+  writer.WriteInteger(summary_efficiency);
+  writer.WriteChar('\n');
   for (const auto &player: team) {
-    output_stream << player.number << " ";
+    writer.WriteInteger(player.number);
+    writer.WriteChar(' ');
   }
-  output_stream << "\n";
+  writer.WriteChar('\n');
 }
 
 int main() {
-  std::ios_base::sync_with_stdio(false);
-  const auto team = ReadPlayers();
+  FastReader reader;
+  FastWriter writer;
+  const auto team = ReadPlayers(reader);
   auto most_effective_solidary_team = BuildMostEffectiveSolidaryTeam(team);
   QuickSort(most_effective_solidary_team.begin(), most_effective_solidary_team.end(),
             ComparePlayersNumber());
-  WriteTeam(most_effective_solidary_team);
+  WriteTeam(most_effective_solidary_team, writer);
 }
@@ -1,22 +1,42 @@
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
 #include <vector>
 #include <stack>
 #include <algorithm>
 
-void read_input(std::vector<std::vector<int>>& triples, std::istream& in_stream = std::cin) {
-  int size;
-  in_stream >> size;
-  for (int i = 0; i < size; ++i) {
-    std::vector<int> triple(3);
-    for (int j = 0; j < 3; ++j) {
-      in_stream >> triple[j];
+#include "../common/fast_io.h"
+
+template <size_t Dimension>
+using Point = std::array<int, Dimension>;
+
+constexpr size_t TRIPLE_DIMENSION = 3;
+constexpr int CHAIN_BRUTE_FORCE_SIZE = 32;
+constexpr int DOMINATION_BRUTE_FORCE_SIZE = 16;
+constexpr double BENCHMARK_TIME_LIMIT_SECONDS = 1.0;
+constexpr int PARALLEL_BENCHMARK_SIZE = 50000;
+
+template <size_t Dimension>
+void read_input(std::vector<Point<Dimension>>& points, FastReader& reader) {
+  int size = reader.ReadInteger();
+  points.resize(size);
+  for (auto &point: points) {
+    for (auto &coordinate: point) {
+      coordinate = reader.ReadInteger();
     }
-    triples.push_back(triple);
   }
 }
 
-void print_triples(const std::vector<std::vector<int>>& triples) {
-  for (auto &i: triples) {
+template <size_t Dimension>
+void print_points(const std::vector<Point<Dimension>>& points) {
+  for (auto &i: points) {
     for (auto &j :i) {
       std::cout << j << " ";
     }
@@ -24,31 +44,578 @@ void print_triples(const std::vector<std::vector<int>>& triples) {
   }
 }
 
-bool compare_triples(const std::vector<int>& first, const std::vector<int>& second) {
-  for (int i = 0; i < first.size(); ++i) {
+template <size_t Dimension>
+bool compare_points(const Point<Dimension>& first, const Point<Dimension>& second) {
+  for (size_t i = 0; i < Dimension; ++i) {
     if (first[i] >= second[i])
       return false;
   }
   return true;
 }
 
-int get_max_chain(const std::vector<std::vector<int>>& triples) {
-  auto size = triples.size();
-  std::vector<int> dynamics(size);
-  for (int i = size - 1; i >= 0; --i) {
-    dynamics[i] = 1;
-    for (int j = size - 1; j > i; --j) {
-      if (compare_triples(triples[i], triples[j])) {
-        dynamics[i] = std::max(dynamics[i], dynamics[j] + 1);
+/*
+ * Цепочка — это подпоследовательность входа, в которой каждая точка
+ * строго больше предыдущей по всем координатам, поэтому доминирование
+ * здесь (Dimension + 1)-мерное: по номеру точки и по её координатам.
+ * chain_lengths[i] — длина самой длинной цепочки, оканчивающейся в i,
+ * previous[i] — предыдущая точка этой цепочки.
+ *
+ * Внешний «разделяй и властвуй» (CDQ) идёт по номеру: посчитав левую
+ * половину отрезка, передаём её ответы в правую и только потом считаем
+ * правую. Передача — статическая задача о доминировании по координатам:
+ * для каждой точки справа найти лучшую точку слева, меньшую по всем
+ * координатам. Каждая координата, кроме двух последних, снимается своим
+ * уровнем вложенного CDQ (на нижнем из них половины сливаются, а не
+ * сортируются заново), последние две — проходом в порядке предпоследней
+ * с деревом Фенвика на максимум по сжатой последней. Итого
+ * O(n log^Dimension n); короткие отрезки досчитываются перебором.
+ */
+
+template <size_t Dimension>
+class ChainSolver {
+ public:
+  static_assert(Dimension >= 2, "Chains need at least two coordinates");
+
+  explicit ChainSolver(const std::vector<Point<Dimension>>& points):
+      points_(points),
+      chain_lengths_(points.size(), 1),
+      previous_(points.size(), -1),
+      last_ranks_(points.size()),
+      fenwick_(points.size() + 1, 0),
+      items_(Dimension - 1) {
+    std::vector<int> last_coordinates(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+      last_coordinates[i] = points[i][Dimension - 1];
+    }
+    std::sort(last_coordinates.begin(), last_coordinates.end());
+    last_coordinates.erase(std::unique(last_coordinates.begin(), last_coordinates.end()),
+                           last_coordinates.end());
+    for (size_t i = 0; i < points.size(); ++i) {
+      last_ranks_[i] = std::lower_bound(last_coordinates.begin(), last_coordinates.end(),
+                                        points[i][Dimension - 1]) - last_coordinates.begin() + 1;
+    }
+  }
+
+  /*
+   * Номера точек самой длинной цепочки в порядке возрастания.
+   */
+  std::vector<int> GetLongestChain() {
+    std::vector<int> chain;
+    if (points_.empty()) {
+      return chain;
+    }
+    SolveRange(0, points_.size());
+    int index = std::max_element(chain_lengths_.begin(), chain_lengths_.end()) -
+        chain_lengths_.begin();
+    for (; index != -1; index = previous_[index]) {
+      chain.push_back(index);
+    }
+    std::reverse(chain.begin(), chain.end());
+    return chain;
+  }
+
+ private:
+  /*
+   * Элемент задачи о доминировании: точка из левой половины (source),
+   * чей ответ уже известен, или точка из правой (query), для которой
+   * ищется лучший предшественник. Координаты скопированы в элемент,
+   * чтобы сортировка и слияние не ходили в points_. В ключах признак
+   * source занимает младший бит, поэтому при равных координатах запросы
+   * идут раньше источников и равенство не считается доминированием.
+   * Последняя координата хранится только рангом для дерева Фенвика.
+   */
+  struct Item {
+    std::array<int64_t, Dimension - 1> keys;
+    int last_rank;
+    int index;
+
+    bool source() const {
+      return keys[0] & 1;
+    }
+  };
+
+  const std::vector<Point<Dimension>>& points_;
+  std::vector<int> chain_lengths_;
+  std::vector<int> previous_;
+  std::vector<int> last_ranks_;
+  std::vector<int64_t> fenwick_;
+  int fenwick_size_;
+  std::vector<std::vector<Item>> items_;
+  std::vector<Item> buffer_;
+
+  Item MakeItem(int index, bool source) const {
+    Item item;
+    for (size_t coordinate = 0; coordinate + 1 < Dimension; ++coordinate) {
+      item.keys[coordinate] = 2 * static_cast<int64_t>(points_[index][coordinate]) + source;
+    }
+    item.last_rank = last_ranks_[index];
+    item.index = index;
+    return item;
+  }
+
+  /*
+   * Длина цепочки и номер её конца, упакованные так, что большее число
+   * соответствует более длинной цепочке.
+   */
+  int64_t PackChain(int index) const {
+    return (static_cast<int64_t>(chain_lengths_[index]) << 32) | static_cast<uint32_t>(index);
+  }
+
+  void Extend(int index, int64_t best_chain) {
+    int best_length = best_chain >> 32;
+    if (best_length + 1 > chain_lengths_[index]) {
+      chain_lengths_[index] = best_length + 1;
+      previous_[index] = static_cast<uint32_t>(best_chain);
+    }
+  }
+
+  void SolveRange(int begin, int end) {
+    if (end - begin <= CHAIN_BRUTE_FORCE_SIZE) {
+      for (int i = begin; i < end; ++i) {
+        for (int j = begin; j < i; ++j) {
+          if (compare_points(points_[j], points_[i])) {
+            Extend(i, PackChain(j));
+          }
+        }
+      }
+      return;
+    }
+    int middle = begin + (end - begin) / 2;
+    SolveRange(begin, middle);
+    auto &items = items_[0];
+    items.clear();
+    for (int i = begin; i < end; ++i) {
+      items.push_back(MakeItem(i, i < middle));
+    }
+    CompressLastRanks(items);
+    Dominate(0, items);
+    SolveRange(middle, end);
+  }
+
+  /*
+   * Перенумеровывает последнюю координату внутри текущей передачи, чтобы
+   * дерево Фенвика занимало столько ячеек, сколько в ней точек, и на
+   * нижних уровнях рекурсии помещалось в кеш.
+   */
+  void CompressLastRanks(std::vector<Item>& items) {
+    std::sort(items.begin(), items.end(), [](const Item& first, const Item& second) {
+      return first.last_rank < second.last_rank;
+    });
+    int previous_rank = 0;
+    fenwick_size_ = 1;
+    for (auto &item: items) {
+      if (item.last_rank != previous_rank) {
+        previous_rank = item.last_rank;
+        ++fenwick_size_;
+      }
+      item.last_rank = fenwick_size_ - 1;
+    }
+  }
+
+  /*
+   * Передаёт ответы источников запросам, которые доминируют их по
+   * координатам с номерами не меньше coordinate.
+   */
+  void Dominate(size_t coordinate, std::vector<Item>& items) {
+    std::sort(items.begin(), items.end(), [coordinate](const Item& first, const Item& second) {
+      return first.keys[coordinate] < second.keys[coordinate];
+    });
+    if (coordinate + 2 == Dimension) {
+      SweepLast(items);
+    } else if (coordinate + 3 == Dimension) {
+      buffer_.resize(std::max(buffer_.size(), items.size()));
+      MergeDominate(coordinate + 1, items, 0, items.size());
+    } else {
+      SplitDominate(coordinate, items, 0, items.size());
+    }
+  }
+
+  /*
+   * Остались две координаты, по первой из них items уже упорядочены.
+   */
+  void SweepLast(const std::vector<Item>& items) {
+    for (const auto &item: items) {
+      if (item.source()) {
+        UpdateFenwick(item.last_rank, PackChain(item.index));
+      } else {
+        Extend(item.index, QueryFenwick(item.last_rank - 1));
+      }
+    }
+    for (const auto &item: items) {
+      if (item.source()) {
+        ClearFenwick(item.last_rank);
+      }
+    }
+  }
+
+  /*
+   * items[begin, end) упорядочены по координате coordinate - 1; на выходе
+   * они упорядочены по coordinate. Остались только эти две координаты и
+   * последняя.
+   */
+  void MergeDominate(size_t coordinate, std::vector<Item>& items, int begin, int end) {
+    if (end - begin <= DOMINATION_BRUTE_FORCE_SIZE) {
+      DominateBruteForce(coordinate, items, begin, end);
+      std::sort(items.begin() + begin, items.begin() + end,
+                [coordinate](const Item& first, const Item& second) {
+                  return first.keys[coordinate] < second.keys[coordinate];
+                });
+      return;
+    }
+    int middle = begin + (end - begin) / 2;
+    MergeDominate(coordinate, items, begin, middle);
+    MergeDominate(coordinate, items, middle, end);
+    int left = begin;
+    for (int right = middle; right < end; ++right) {
+      if (items[right].source()) {
+        continue;
+      }
+      for (; left < middle && items[left].keys[coordinate] < items[right].keys[coordinate];
+           ++left) {
+        if (items[left].source()) {
+          UpdateFenwick(items[left].last_rank, PackChain(items[left].index));
+        }
+      }
+      Extend(items[right].index, QueryFenwick(items[right].last_rank - 1));
+    }
+    for (int i = begin; i < left; ++i) {
+      if (items[i].source()) {
+        ClearFenwick(items[i].last_rank);
+      }
+    }
+    std::merge(items.begin() + begin, items.begin() + middle,
+               items.begin() + middle, items.begin() + end, buffer_.begin() + begin,
+               [coordinate](const Item& first, const Item& second) {
+                 return first.keys[coordinate] < second.keys[coordinate];
+               });
+    std::copy(buffer_.begin() + begin, buffer_.begin() + end, items.begin() + begin);
+  }
+
+  /*
+   * items[begin, end) упорядочены по координате coordinate; источники
+   * левой половины передаются запросам правой через следующий уровень.
+   */
+  void SplitDominate(size_t coordinate, std::vector<Item>& items, int begin, int end) {
+    if (end - begin <= DOMINATION_BRUTE_FORCE_SIZE) {
+      DominateBruteForce(coordinate + 1, items, begin, end);
+      return;
+    }
+    int middle = begin + (end - begin) / 2;
+    SplitDominate(coordinate, items, begin, middle);
+    SplitDominate(coordinate, items, middle, end);
+    auto &next_items = items_[coordinate + 1];
+    next_items.clear();
+    bool has_sources = false;
+    bool has_queries = false;
+    for (int i = begin; i < middle; ++i) {
+      if (items[i].source()) {
+        next_items.push_back(items[i]);
+        has_sources = true;
+      }
+    }
+    for (int i = middle; i < end; ++i) {
+      if (!items[i].source()) {
+        next_items.push_back(items[i]);
+        has_queries = true;
+      }
+    }
+    if (has_sources && has_queries) {
+      Dominate(coordinate + 1, next_items);
+    }
+  }
+
+  /*
+   * items[begin, end) упорядочены по координате from_coordinate - 1;
+   * сравниваются все координаты начиная с from_coordinate.
+   */
+  void DominateBruteForce(size_t from_coordinate, const std::vector<Item>& items,
+                          int begin, int end) {
+    for (int right = begin + 1; right < end; ++right) {
+      if (items[right].source()) {
+        continue;
+      }
+      for (int left = begin; left < right; ++left) {
+        if (items[left].source() && ItemDominates(from_coordinate, items[left], items[right])) {
+          Extend(items[right].index, PackChain(items[left].index));
+        }
+      }
+    }
+  }
+
+  static bool ItemDominates(size_t from_coordinate, const Item& smaller, const Item& larger) {
+    for (size_t coordinate = from_coordinate; coordinate + 1 < Dimension; ++coordinate) {
+      if (smaller.keys[coordinate] >= larger.keys[coordinate]) {
+        return false;
+      }
+    }
+    return smaller.last_rank < larger.last_rank;
+  }
+
+  void UpdateFenwick(int position, int64_t value) {
+    for (; position < fenwick_size_; position += position & -position) {
+      fenwick_[position] = std::max(fenwick_[position], value);
+    }
+  }
+
+  void ClearFenwick(int position) {
+    for (; position < fenwick_size_; position += position & -position) {
+      fenwick_[position] = 0;
+    }
+  }
+
+  int64_t QueryFenwick(int position) const {
+    int64_t result = 0;
+    for (; position > 0; position -= position & -position) {
+      result = std::max(result, fenwick_[position]);
+    }
+    return result;
+  }
+};
+
+template <size_t Dimension>
+std::vector<int> get_longest_chain(const std::vector<Point<Dimension>>& points) {
+  return ChainSolver<Dimension>(points).GetLongestChain();
+}
+
+template <size_t Dimension>
+int get_max_chain(const std::vector<Point<Dimension>>& points) {
+  return get_longest_chain(points).size();
+}
+
+/*
+ * Точная квадратичная динамика, распараллеленная блоками по
+ * WAVEFRONT_BLOCK_SIZE точек входа. Для очередного блока потоки делят
+ * между собой его точки и для каждой ищут лучшую цепочку среди уже
+ * досчитанных блоков; затем один поток досчитывает вклад точек внутри
+ * блока, и только после этого начинается следующий блок. Координаты
+ * лежат по столбцам (SoA), а внутренний цикл сравнивает точку с отрезком
+ * столбцов без ветвлений, векторным сравнением и маской.
+ */
+
+constexpr int WAVEFRONT_BLOCK_SIZE = 512;
+
+class Barrier {
+ public:
+  explicit Barrier(int threads_count):
+      threads_count_(threads_count), waiting_count_(0), generation_(0)
+  {}
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto generation = generation_;
+    if (++waiting_count_ == threads_count_) {
+      waiting_count_ = 0;
+      ++generation_;
+      condition_.notify_all();
+      return;
+    }
+    condition_.wait(lock, [&] { return generation != generation_; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  int threads_count_;
+  int waiting_count_;
+  uint64_t generation_;
+};
+
+template <size_t Dimension>
+struct PointColumns {
+  std::array<std::vector<int>, Dimension> columns;
+
+  explicit PointColumns(const std::vector<Point<Dimension>>& points) {
+    for (size_t coordinate = 0; coordinate < Dimension; ++coordinate) {
+      columns[coordinate].resize(points.size());
+      for (size_t i = 0; i < points.size(); ++i) {
+        columns[coordinate][i] = points[i][coordinate];
+      }
+    }
+  }
+};
+
+/*
+ * Наибольшая длина цепочки, оканчивающейся в j из [begin, end) и
+ * продолжаемой точкой point. Основной цикл обрабатывает по
+ * INT_VECTOR_SIZE точек векторными расширениями GCC: сравнение столбца с
+ * размноженной координатой даёт маску из 0 и -1, маски перемножаются
+ * побитовым и, и маска обнуляет длины не подходящих точек.
+ */
+
+using IntVector = int __attribute__((vector_size(16)));
+constexpr int INT_VECTOR_SIZE = sizeof(IntVector) / sizeof(int);
+
+template <size_t Dimension>
+int get_best_dominated_chain(const PointColumns<Dimension>& points, const int* chain_lengths,
+                             int begin, int end, int point) {
+  std::array<const int*, Dimension> columns;
+  std::array<int, Dimension> bounds;
+  std::array<IntVector, Dimension> bound_vectors;
+  for (size_t coordinate = 0; coordinate < Dimension; ++coordinate) {
+    columns[coordinate] = points.columns[coordinate].data();
+    bounds[coordinate] = columns[coordinate][point];
+    bound_vectors[coordinate] = IntVector{} + bounds[coordinate];
+  }
+  IntVector best_vector = {};
+  int j = begin;
+  for (; j + INT_VECTOR_SIZE <= end; j += INT_VECTOR_SIZE) {
+    IntVector mask = ~IntVector{};
+    for (size_t coordinate = 0; coordinate < Dimension; ++coordinate) {
+      IntVector column;
+      std::memcpy(&column, columns[coordinate] + j, sizeof(column));
+      mask &= column < bound_vectors[coordinate];
+    }
+    IntVector lengths;
+    std::memcpy(&lengths, chain_lengths + j, sizeof(lengths));
+    lengths &= mask;
+    best_vector = best_vector > lengths ? best_vector : lengths;
+  }
+  int best = 0;
+  for (int lane = 0; lane < INT_VECTOR_SIZE; ++lane) {
+    best = std::max(best, best_vector[lane]);
+  }
+  for (; j < end; ++j) {
+    int dominated = 1;
+    for (size_t coordinate = 0; coordinate < Dimension; ++coordinate) {
+      dominated &= columns[coordinate][j] < bounds[coordinate];
+    }
+    best = std::max(best, chain_lengths[j] & -dominated);
+  }
+  return best;
+}
+
+template <size_t Dimension>
+int get_max_chain_parallel(const std::vector<Point<Dimension>>& points, int threads_count) {
+  int size = points.size();
+  if (size == 0) {
+    return 0;
+  }
+  PointColumns<Dimension> columns(points);
+  std::vector<int> chain_lengths(size);
+  Barrier barrier(threads_count);
+  auto worker = [&](int thread_index) {
+    for (int block_begin = 0; block_begin < size; block_begin += WAVEFRONT_BLOCK_SIZE) {
+      int block_end = std::min(size, block_begin + WAVEFRONT_BLOCK_SIZE);
+      for (int i = block_begin + thread_index; i < block_end; i += threads_count) {
+        chain_lengths[i] = 1 + get_best_dominated_chain(columns, chain_lengths.data(),
+                                                        0, block_begin, i);
+      }
+      barrier.Wait();
+      if (thread_index == 0) {
+        for (int i = block_begin; i < block_end; ++i) {
+          chain_lengths[i] = std::max(chain_lengths[i], 1 + get_best_dominated_chain(
+              columns, chain_lengths.data(), block_begin, i, i));
+        }
+      }
+      barrier.Wait();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int thread_index = 1; thread_index < threads_count; ++thread_index) {
+    threads.emplace_back(worker, thread_index);
+  }
+  worker(0);
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  return *std::max_element(chain_lengths.begin(), chain_lengths.end());
+}
+
+/*
+ * Замеры для размерностей 2..6 на случайных точках: n растёт в десять
+ * раз, пока очередной замер не превысит BENCHMARK_TIME_LIMIT_SECONDS
+ * или n не дойдёт до миллиона.
+ */
+
+template <size_t Dimension>
+void benchmark_dimension(FastWriter& writer) {
+  std::mt19937 generator(Dimension);
+  for (int size = 1000; size <= 1000000; size *= 10) {
+    std::uniform_int_distribution<int> gen_uniform_coordinate(0, size);
+    std::vector<Point<Dimension>> points(size);
+    for (auto &point: points) {
+      for (auto &coordinate: point) {
+        coordinate = gen_uniform_coordinate(generator);
       }
     }
+    auto start = std::chrono::steady_clock::now();
+    int chain_length = get_max_chain(points);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    writer.WriteFormatted("d=%zu n=%d: chain %d, %.3f s\n", Dimension, size, chain_length,
+                          elapsed.count());
+    if (elapsed.count() > BENCHMARK_TIME_LIMIT_SECONDS) {
+      break;
+    }
+  }
+}
+
+void write_benchmark(FastWriter& writer) {
+  benchmark_dimension<2>(writer);
+  benchmark_dimension<3>(writer);
+  benchmark_dimension<4>(writer);
+  benchmark_dimension<5>(writer);
+  benchmark_dimension<6>(writer);
+}
+
+/*
+ * Ускорение параллельной динамики на PARALLEL_BENCHMARK_SIZE случайных
+ * тройках в зависимости от числа потоков.
+ */
+
+void write_parallel_benchmark(FastWriter& writer) {
+  std::mt19937 generator(TRIPLE_DIMENSION);
+  std::uniform_int_distribution<int> gen_uniform_coordinate(0, PARALLEL_BENCHMARK_SIZE);
+  std::vector<Point<TRIPLE_DIMENSION>> triples(PARALLEL_BENCHMARK_SIZE);
+  for (auto &triple: triples) {
+    for (auto &coordinate: triple) {
+      coordinate = gen_uniform_coordinate(generator);
+    }
+  }
+  int max_threads = std::max(4u, std::thread::hardware_concurrency());
+  double single_thread_seconds = 0;
+  for (int threads_count = 1; ; threads_count = std::min(2 * threads_count, max_threads)) {
+    auto start = std::chrono::steady_clock::now();
+    int chain_length = get_max_chain_parallel(triples, threads_count);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (threads_count == 1) {
+      single_thread_seconds = elapsed.count();
+    }
+    writer.WriteFormatted("%d threads: chain %d, %.3f s, speedup %.2f\n", threads_count,
+                          chain_length, elapsed.count(), single_thread_seconds / elapsed.count());
+    if (threads_count == max_threads) {
+      break;
+    }
   }
-  return *std::max_element(dynamics.begin(), dynamics.end());
 }
 
-int main() {
-  std::vector<std::vector<int>> triples;
-  read_input(triples);
-  std::cout << get_max_chain(triples) << std::endl;
+int main(int argc, char* argv[]) {
+  FastWriter writer;
+  std::string option = argc > 1 ? argv[1] : "";
+  if (option == "--bench") {
+    write_benchmark(writer);
+    return 0;
+  }
+  if (option == "--bench-parallel") {
+    write_parallel_benchmark(writer);
+    return 0;
+  }
+  FastReader reader;
+  std::vector<Point<TRIPLE_DIMENSION>> triples;
+  read_input(triples, reader);
+  if (option == "--threads" && argc > 2) {
+    writer.WriteInteger(get_max_chain_parallel(triples, std::max(1, std::stoi(argv[2]))));
+    writer.WriteChar('\n');
+    return 0;
+  }
+  auto chain = get_longest_chain(triples);
+  writer.WriteInteger(chain.size());
+  writer.WriteChar('\n');
+  if (option == "--chain") {
+    for (auto index: chain) {
+      writer.WriteInteger(index + 1);
+      writer.WriteChar(' ');
+    }
+    writer.WriteChar('\n');
+  }
   return 0;
 }
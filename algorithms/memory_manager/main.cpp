@@ -1,266 +1,960 @@
 // INTERFACE /////////////////////////////////////
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <list>
-#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <set>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "../common/fast_io.h"
+#include "../common/indexed_heap.h"
+
+constexpr uint32_t NULL_SEGMENT = static_cast<uint32_t>(-1);
+
+struct MemorySegment {
+  size_t left;
+  size_t right;
+  uint32_t prev;
+  uint32_t next;
+  bool free;
+
+  MemorySegment(size_t left_, size_t right_):
+      left(left_),
+      right(right_),
+      prev(NULL_SEGMENT),
+      next(NULL_SEGMENT),
+      free(false)
+  {}
+
+  size_t size() const {
+    return right - left;
+  }
+
+  void Absorb(const MemorySegment& other) {
+    left = std::min(left, other.left);
+    right = std::max(right, other.right);
+  }
+};
+
 /*
- * Мы реализуем стандартный класс для хранения кучи с возможностью удаления
- * элемента по индексу. Для оповещения элементов об их текущих значениях
- * индексов мы используем функцию index_change_observer.
+ * Пул сегментов: все сегменты лежат в одном векторе и адресуются 32-битными
+ * номерами, а номера удалённых сегментов собираются в список свободных
+ * ячеек (связанный через поле next) и переиспользуются. Поэтому разбиение
+ * и слияние сегментов не выделяют и не освобождают память, кроме редкого
+ * роста вектора.
  */
 
-template <class T, class Compare = std::less<T>>
-class MaxHeap {
+class MemorySegmentPool {
  public:
-  using IndexChangeObserver =
-  std::function<void(const T& element, size_t new_element_index)>;
+  MemorySegmentPool(): free_list_(NULL_SEGMENT)
+  {}
+
+  uint32_t Create(size_t left, size_t right) {
+    if (free_list_ == NULL_SEGMENT) {
+      segments_.emplace_back(left, right);
+      return segments_.size() - 1;
+    }
+    auto index = free_list_;
+    free_list_ = segments_[index].next;
+    segments_[index] = MemorySegment(left, right);
+    return index;
+  }
+
+  void Destroy(uint32_t index) {
+    segments_[index].next = free_list_;
+    free_list_ = index;
+  }
+
+  MemorySegment& operator[](uint32_t index) {
+    return segments_[index];
+  }
+
+  const MemorySegment& operator[](uint32_t index) const {
+    return segments_[index];
+  }
+
+ private:
+  std::vector<MemorySegment> segments_;
+  uint32_t free_list_;
+};
 
-  static constexpr size_t kNullIndex = static_cast<size_t>(-1);
+/*
+ * Политики размещения решают, какой из свободных сегментов отдать под
+ * очередной запрос. Менеджер памяти сам режет и склеивает сегменты,
+ * а политике только сообщает, что сегмент стал свободным (Insert) или
+ * перестал им быть (Erase); Erase вызывается до того, как границы
+ * сегмента поменяются. Find возвращает номер подходящего свободного
+ * сегмента или NULL_SEGMENT, LargestFreeSize — длину наибольшего из них.
+ * Свои служебные данные политика хранит в векторах, индексированных
+ * номером сегмента в пуле, а не в самом сегменте.
+ */
+
+template <class Value>
+void EnsureSegmentSlot(std::vector<Value>& values, uint32_t segment, Value value = Value()) {
+  if (segment >= values.size()) {
+    values.resize(segment + 1, value);
+  }
+}
+
+/*
+ * Элемент кучи worst fit несёт длину и левую границу сегмента с собой:
+ * политика узнаёт о сегменте до изменения его границ и после него, так
+ * что копия всегда актуальна, а сравнения при просеивании не ходят в пул.
+ */
+
+struct FreeSegmentKey {
+  size_t size;
+  size_t left;
+  uint32_t segment;
+};
+
+struct FreeSegmentKeyCompare {
+  bool operator()(const FreeSegmentKey& first, const FreeSegmentKey& second) const {
+    if (first.size == second.size) {
+      return first.left >= second.left;
+    }
+    return first.size < second.size;
+  }
+};
 
-  explicit MaxHeap(
-      Compare compare = Compare(),
-      IndexChangeObserver index_change_observer = IndexChangeObserver()):
-      index_change_observer_(index_change_observer),
-      compare_(compare)
+struct FreeSegmentKeyObserver {
+  std::vector<uint32_t>* heap_indices;
+
+  void operator()(const FreeSegmentKey& key, size_t new_index) const {
+    (*heap_indices)[key.segment] = static_cast<uint32_t>(new_index);
+  }
+};
+
+/*
+ * Worst fit: самый левый из наидлиннейших свободных сегментов, который
+ * достаётся из кучи. Позицию сегмента в куче поддерживает
+ * index_change_observer.
+ */
+
+class WorstFitPolicy {
+ public:
+  static constexpr const char* NAME = "worst-fit";
+
+  explicit WorstFitPolicy(const MemorySegmentPool* segments):
+      segments_(segments),
+      heap_(FreeSegmentKeyCompare(), FreeSegmentKeyObserver{&heap_indices_})
   {}
 
-  void Push(const T& value) {
-    elements_.push_back(value);
-    NotifyIndexChange(value, size() - 1);
-    SiftUp(size() - 1);
+  WorstFitPolicy(const WorstFitPolicy&) = delete;
+  WorstFitPolicy& operator=(const WorstFitPolicy&) = delete;
+
+  void Insert(uint32_t segment) {
+    EnsureSegmentSlot(heap_indices_, segment);
+    const auto &memory_segment = (*segments_)[segment];
+    heap_.Push(FreeSegmentKey{memory_segment.size(), memory_segment.left, segment});
   }
 
-  void Erase(size_t index) {
-    NotifyIndexChange(elements_[index], kNullIndex);
-    if (size() > 1) {
-      elements_[index] = elements_[size() - 1];
-      NotifyIndexChange(elements_[index], index);
+  void Erase(uint32_t segment) {
+    heap_.Erase(heap_indices_[segment]);
+  }
+
+  uint32_t Find(size_t size) const {
+    if (heap_.empty() || heap_.top().size < size) {
+      return NULL_SEGMENT;
     }
-    elements_.pop_back();
-    SiftDown(index);
-    SiftUp(index);
+    return heap_.top().segment;
   }
 
-  const T& top() const {
-    return elements_[0];
+  size_t LargestFreeSize() const {
+    return heap_.empty() ? 0 : heap_.top().size;
   }
 
-  void Pop() {
-    Erase(0);
+ private:
+  using SegmentHeap = IndexedHeap<FreeSegmentKey, FreeSegmentKeyCompare, FreeSegmentKeyObserver, 4>;
+
+  const MemorySegmentPool* segments_;
+  std::vector<uint32_t> heap_indices_;
+  SegmentHeap heap_;
+};
+
+/*
+ * Best fit: самый короткий из достаточно длинных сегментов (при равенстве
+ * самый левый). Свободные сегменты лежат в сбалансированном дереве
+ * std::set, упорядоченном по паре (длина, левая граница).
+ */
+
+class BestFitPolicy {
+ public:
+  static constexpr const char* NAME = "best-fit";
+
+  explicit BestFitPolicy(const MemorySegmentPool* segments): segments_(segments)
+  {}
+
+  void Insert(uint32_t segment) {
+    by_size_.insert(Key(segment));
   }
 
-  size_t size() const {
-    return elements_.size();
+  void Erase(uint32_t segment) {
+    by_size_.erase(Key(segment));
+  }
+
+  uint32_t Find(size_t size) const {
+    auto it = by_size_.lower_bound(std::make_tuple(size, size_t(0), uint32_t(0)));
+    return it == by_size_.end() ? NULL_SEGMENT : std::get<2>(*it);
   }
 
-  bool empty() const {
-    return elements_.empty();
+  size_t LargestFreeSize() const {
+    return by_size_.empty() ? 0 : std::get<0>(*by_size_.rbegin());
   }
 
  private:
-  IndexChangeObserver index_change_observer_;
-  Compare compare_;
-  std::vector<T> elements_;
+  using SizeKey = std::tuple<size_t, size_t, uint32_t>;
 
-  size_t parent(size_t index) const {
-    if (index != 0) {
-      return (index - 1) / 2;
-    }
-    return kNullIndex;
+  const MemorySegmentPool* segments_;
+  std::set<SizeKey> by_size_;
+
+  SizeKey Key(uint32_t segment) const {
+    const auto& memory_segment = (*segments_)[segment];
+    return SizeKey(memory_segment.size(), memory_segment.left, segment);
   }
+};
 
-  size_t left_son(size_t index) const {
-    if (2 * index + 1 < size()) {
-      return 2 * index + 1;
-    }
-    return kNullIndex;
+/*
+ * First fit: самый левый из достаточно длинных сегментов. Свободные
+ * сегменты лежат в декартовом дереве по левой границе, и каждая вершина
+ * помнит наибольшую длину сегмента в своём поддереве, поэтому спуск к
+ * самому левому подходящему сегменту занимает O(log n).
+ */
+
+class FirstFitPolicy {
+ public:
+  static constexpr const char* NAME = "first-fit";
+
+  explicit FirstFitPolicy(const MemorySegmentPool* segments):
+      segments_(segments), root_(NULL_SEGMENT)
+  {}
+
+  void Insert(uint32_t segment) {
+    EnsureSegmentSlot(left_son_, segment, NULL_SEGMENT);
+    EnsureSegmentSlot(right_son_, segment, NULL_SEGMENT);
+    EnsureSegmentSlot(priority_, segment);
+    EnsureSegmentSlot(max_size_, segment);
+    left_son_[segment] = right_son_[segment] = NULL_SEGMENT;
+    priority_[segment] = generator_();
+    Update(segment);
+    uint32_t less, greater;
+    Split(root_, (*segments_)[segment].left, less, greater);
+    root_ = Merge(Merge(less, segment), greater);
+  }
+
+  void Erase(uint32_t segment) {
+    auto left = (*segments_)[segment].left;
+    uint32_t less, not_less, equal, greater;
+    Split(root_, left, less, not_less);
+    Split(not_less, left + 1, equal, greater);
+    root_ = Merge(less, greater);
   }
 
-  size_t right_son(size_t index) const {
-    if (2 * index + 2 < size()) {
-      return 2 * index + 2;
+  uint32_t Find(size_t size) const {
+    if (MaxSize(root_) < size) {
+      return NULL_SEGMENT;
+    }
+    auto vertex = root_;
+    while (true) {
+      if (MaxSize(left_son_[vertex]) >= size) {
+        vertex = left_son_[vertex];
+      } else if ((*segments_)[vertex].size() >= size) {
+        return vertex;
+      } else {
+        vertex = right_son_[vertex];
+      }
     }
-    return kNullIndex;
   }
 
-  bool CompareElements(size_t first_index, size_t second_index) const {
-    return compare_(elements_[second_index], elements_[first_index]);
+  size_t LargestFreeSize() const {
+    return MaxSize(root_);
   }
 
-  void NotifyIndexChange(const T& element, size_t new_element_index) {
-    if (!index_change_observer_) {
+ private:
+  const MemorySegmentPool* segments_;
+  uint32_t root_;
+  std::vector<uint32_t> left_son_;
+  std::vector<uint32_t> right_son_;
+  std::vector<uint32_t> priority_;
+  std::vector<size_t> max_size_;
+  std::mt19937 generator_;
+
+  size_t MaxSize(uint32_t vertex) const {
+    return vertex == NULL_SEGMENT ? 0 : max_size_[vertex];
+  }
+
+  void Update(uint32_t vertex) {
+    max_size_[vertex] = std::max({(*segments_)[vertex].size(),
+                                  MaxSize(left_son_[vertex]),
+                                  MaxSize(right_son_[vertex])});
+  }
+
+  /*
+   * Делит дерево на сегменты с левой границей меньше key и все остальные.
+   */
+  void Split(uint32_t vertex, size_t key, uint32_t& less, uint32_t& not_less) {
+    if (vertex == NULL_SEGMENT) {
+      less = not_less = NULL_SEGMENT;
       return;
     }
-    index_change_observer_(element, new_element_index);
+    if ((*segments_)[vertex].left < key) {
+      Split(right_son_[vertex], key, right_son_[vertex], not_less);
+      less = vertex;
+    } else {
+      Split(left_son_[vertex], key, less, left_son_[vertex]);
+      not_less = vertex;
+    }
+    Update(vertex);
+  }
+
+  uint32_t Merge(uint32_t less, uint32_t greater) {
+    if (less == NULL_SEGMENT || greater == NULL_SEGMENT) {
+      return less == NULL_SEGMENT ? greater : less;
+    }
+    if (priority_[less] > priority_[greater]) {
+      right_son_[less] = Merge(right_son_[less], greater);
+      Update(less);
+      return less;
+    }
+    left_son_[greater] = Merge(less, left_son_[greater]);
+    Update(greater);
+    return greater;
+  }
+};
+
+/*
+ * Segregated fit в духе TLSF: каждый степенной диапазон [2^k, 2^(k+1))
+ * поделён на SUB_CLASSES_COUNT равных классов (размеры меньше
+ * SUB_CLASSES_COUNT имеют по классу на каждый), класс — интрузивный
+ * двусвязный список, а непустые классы отмечены битами в двухуровневой
+ * маске. Запрос округляется вверх до границы класса, так что любой
+ * сегмент найденного класса заведомо подходит, и Find делает не больше
+ * двух поисков младшего бита. Иначе проверяется лишь голова класса самого
+ * запроса: в нём подходят не все сегменты, и запрос может получить отказ,
+ * хотя где-то в этом классе (все его сегменты короче запроса не больше
+ * чем на 1/SUB_CLASSES_COUNT) подходящий сегмент есть.
+ */
+
+class SegregatedFitPolicy {
+ public:
+  static constexpr const char* NAME = "segregated";
+
+  explicit SegregatedFitPolicy(const MemorySegmentPool* segments):
+      segments_(segments), non_empty_words_(0) {
+    std::fill(std::begin(heads_), std::end(heads_), NULL_SEGMENT);
+    std::fill(std::begin(non_empty_classes_), std::end(non_empty_classes_), 0);
   }
 
-  void SwapElements(size_t first_index, size_t second_index) {
-    std::swap(elements_[first_index], elements_[second_index]);
-    NotifyIndexChange(elements_[first_index], first_index);
-    NotifyIndexChange(elements_[second_index], second_index);
+  void Insert(uint32_t segment) {
+    EnsureSegmentSlot(prev_, segment, NULL_SEGMENT);
+    EnsureSegmentSlot(next_, segment, NULL_SEGMENT);
+    auto size_class = SizeClass((*segments_)[segment].size());
+    prev_[segment] = NULL_SEGMENT;
+    next_[segment] = heads_[size_class];
+    if (heads_[size_class] != NULL_SEGMENT) {
+      prev_[heads_[size_class]] = segment;
+    }
+    heads_[size_class] = segment;
+    non_empty_classes_[size_class / 64] |= uint64_t(1) << (size_class % 64);
+    non_empty_words_ |= uint64_t(1) << (size_class / 64);
   }
 
-  size_t SiftUp(size_t index) {
-    auto parent_index = parent(index);
-    while (parent_index != kNullIndex) {
-      if (CompareElements(index, parent_index)) {
-        SwapElements(index, parent_index);
+  void Erase(uint32_t segment) {
+    auto size_class = SizeClass((*segments_)[segment].size());
+    if (prev_[segment] != NULL_SEGMENT) {
+      next_[prev_[segment]] = next_[segment];
+    } else {
+      heads_[size_class] = next_[segment];
+    }
+    if (next_[segment] != NULL_SEGMENT) {
+      prev_[next_[segment]] = prev_[segment];
+    }
+    if (heads_[size_class] == NULL_SEGMENT) {
+      non_empty_classes_[size_class / 64] &= ~(uint64_t(1) << (size_class % 64));
+      if (non_empty_classes_[size_class / 64] == 0) {
+        non_empty_words_ &= ~(uint64_t(1) << (size_class / 64));
       }
-      index = parent_index;
-      parent_index = parent(index);
     }
-    return index;
   }
 
-  void SiftDown(size_t index) {
-    if (left_son(index) == kNullIndex && right_son(index) == kNullIndex) {
-      return;
+  uint32_t Find(size_t size) const {
+    auto floor_class = SizeClass(size);
+    auto ceil_class = ClassLowerBound(floor_class) == size ? floor_class : floor_class + 1;
+    auto size_class = FirstNonEmptyClass(ceil_class);
+    if (size_class != SIZE_CLASSES_COUNT) {
+      return heads_[size_class];
     }
-    auto left_son_index = left_son(index);
-    auto right_son_index = right_son(index);
-    auto dominating_index = index;
-    if (left_son_index != kNullIndex && CompareElements(left_son_index, dominating_index)) {
-      dominating_index = left_son_index;
+    auto segment = heads_[floor_class];
+    if (segment != NULL_SEGMENT && (*segments_)[segment].size() >= size) {
+      return segment;
     }
-    if (right_son_index != kNullIndex && CompareElements(right_son_index, dominating_index)) {
-      dominating_index = right_son_index;
+    return NULL_SEGMENT;
+  }
+
+  size_t LargestFreeSize() const {
+    if (non_empty_words_ == 0) {
+      return 0;
     }
-    if (dominating_index == index) {
-      return;
+    auto word = 63 - __builtin_clzll(non_empty_words_);
+    auto size_class = word * 64 + 63 - __builtin_clzll(non_empty_classes_[word]);
+    size_t largest = 0;
+    for (auto segment = heads_[size_class]; segment != NULL_SEGMENT; segment = next_[segment]) {
+      largest = std::max(largest, (*segments_)[segment].size());
     }
-    SwapElements(index, dominating_index);
-    SiftDown(dominating_index);
+    return largest;
   }
-};
 
-struct MemorySegment {
-  size_t left;
-  size_t right;
-  size_t heap_index;
+ private:
+  static constexpr size_t SUB_CLASS_BITS = 4;
+  static constexpr size_t SUB_CLASSES_COUNT = size_t(1) << SUB_CLASS_BITS;
+  static constexpr size_t SIZE_CLASSES_COUNT = (64 - SUB_CLASS_BITS + 1) * SUB_CLASSES_COUNT;
+  static constexpr size_t CLASS_WORDS_COUNT = (SIZE_CLASSES_COUNT + 63) / 64;
+  static_assert(CLASS_WORDS_COUNT <= 64, "Class words must fit into one summary mask");
 
-  MemorySegment(size_t left_, size_t right_);
+  const MemorySegmentPool* segments_;
+  uint32_t heads_[SIZE_CLASSES_COUNT];
+  uint64_t non_empty_classes_[CLASS_WORDS_COUNT];
+  uint64_t non_empty_words_;
+  std::vector<uint32_t> prev_;
+  std::vector<uint32_t> next_;
 
-  size_t size() const {
-    return right - left;
+  static size_t FloorLog2(size_t value) {
+    return 63 - __builtin_clzll(value);
   }
 
-  MemorySegment Unite(const MemorySegment& other) const {
-    return MemorySegment(std::min(left, other.left), std::max(right, other.right));
+  /*
+   * Номер класса размера size: классы идут подряд в порядке возрастания
+   * размеров, и у каждого степенного диапазона их SUB_CLASSES_COUNT.
+   */
+  static size_t SizeClass(size_t size) {
+    if (size < SUB_CLASSES_COUNT) {
+      return size;
+    }
+    auto log = FloorLog2(size);
+    return (log - SUB_CLASS_BITS + 1) * SUB_CLASSES_COUNT +
+           ((size >> (log - SUB_CLASS_BITS)) - SUB_CLASSES_COUNT);
   }
+
+  static size_t ClassLowerBound(size_t size_class) {
+    if (size_class < SUB_CLASSES_COUNT) {
+      return size_class;
+    }
+    auto log = size_class / SUB_CLASSES_COUNT + SUB_CLASS_BITS - 1;
+    return (SUB_CLASSES_COUNT + size_class % SUB_CLASSES_COUNT) << (log - SUB_CLASS_BITS);
+  }
+
+  size_t FirstNonEmptyClass(size_t first_class) const {
+    if (first_class >= SIZE_CLASSES_COUNT) {
+      return SIZE_CLASSES_COUNT;
+    }
+    auto word = first_class / 64;
+    auto classes = non_empty_classes_[word] & (~uint64_t(0) << (first_class % 64));
+    if (classes != 0) {
+      return word * 64 + __builtin_ctzll(classes);
+    }
+    auto words = word + 1 < 64 ? non_empty_words_ & (~uint64_t(0) << (word + 1)) : 0;
+    if (words == 0) {
+      return SIZE_CLASSES_COUNT;
+    }
+    word = __builtin_ctzll(words);
+    return word * 64 + __builtin_ctzll(non_empty_classes_[word]);
+  }
+};
+
+/*
+ * Бинарная трасса вызовов менеджера памяти: заголовок MemoryTraceHeader
+ * и за ним записи MemoryTraceRecord фиксированной длины в родном порядке
+ * байт. Каждое выделение, в том числе неудачное, получает порядковый
+ * номер allocation_id, по которому на него ссылается запись освобождения,
+ * поэтому трассу можно воспроизвести как последовательность запросов
+ * независимо от того, как менеджер нумерует свои сегменты. Записи копятся
+ * в буфере и сбрасываются в файл пачками по TRACE_BUFFER_RECORDS_COUNT.
+ */
+
+constexpr char TRACE_MAGIC[8] = "MMTRACE";
+constexpr uint32_t TRACE_VERSION = 1;
+constexpr size_t TRACE_BUFFER_RECORDS_COUNT = 1 << 12;
+
+enum class MemoryOperation : uint32_t {
+  ALLOCATE = 0,
+  FREE = 1
 };
 
-using MemorySegmentIterator = std::list<MemorySegment>::iterator;
-using MemorySegmentConstIterator = std::list<MemorySegment>::const_iterator;
+struct MemoryTraceHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t memory_size;
+};
+
+struct MemoryTraceRecord {
+  uint64_t timestamp_nanoseconds;
+  uint64_t size;
+  uint64_t position;
+  uint32_t allocation_id;
+  MemoryOperation operation;
+};
+
+static_assert(sizeof(MemoryTraceRecord) == 32, "MemoryTraceRecord must stay compact");
 
-struct MemorySegmentSizeCompare {
-  bool operator()(MemorySegmentIterator first,
-                  MemorySegmentIterator second) const {
-    if (first->size() == second->size()) {
-      return first->left >= second->left;
+class MemoryTraceWriter {
+ public:
+  MemoryTraceWriter(const std::string& path, size_t memory_size):
+      path_(path),
+      stream_(path, std::ios::binary | std::ios::trunc),
+      start_(std::chrono::steady_clock::now()),
+      allocations_count_(0) {
+    MemoryTraceHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(MemoryTraceRecord);
+    header.memory_size = memory_size;
+    stream_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!stream_) {
+      throw std::runtime_error("Cannot write trace to " + path_);
     }
-    return first->size() < second->size();
+    records_.reserve(TRACE_BUFFER_RECORDS_COUNT);
+  }
+
+  MemoryTraceWriter(const MemoryTraceWriter&) = delete;
+  MemoryTraceWriter& operator=(const MemoryTraceWriter&) = delete;
+
+  ~MemoryTraceWriter() {
+    WriteRecords();
+  }
+
+  /*
+   * segment — номер выделенного сегмента в пуле или NULL_SEGMENT при отказе.
+   */
+  void RecordAllocate(uint32_t segment, size_t size, size_t position) {
+    if (segment != NULL_SEGMENT) {
+      EnsureSegmentSlot(allocation_ids_, segment);
+      allocation_ids_[segment] = allocations_count_;
+    }
+    Record(MemoryOperation::ALLOCATE, allocations_count_++, size, position);
+  }
+
+  void RecordFree(uint32_t segment, size_t size, size_t position) {
+    Record(MemoryOperation::FREE, allocation_ids_[segment], size, position);
+  }
+
+  void Close() {
+    WriteRecords();
+    stream_.flush();
+    if (!stream_) {
+      throw std::runtime_error("Cannot write trace to " + path_);
+    }
+  }
+
+ private:
+  std::string path_;
+  std::ofstream stream_;
+  std::chrono::steady_clock::time_point start_;
+  uint32_t allocations_count_;
+  std::vector<uint32_t> allocation_ids_;
+  std::vector<MemoryTraceRecord> records_;
+
+  void Record(MemoryOperation operation, uint32_t allocation_id, size_t size, size_t position) {
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+    records_.push_back({static_cast<uint64_t>(timestamp), size, position, allocation_id, operation});
+    if (records_.size() == TRACE_BUFFER_RECORDS_COUNT) {
+      WriteRecords();
+    }
+  }
+
+  void WriteRecords() {
+    stream_.write(reinterpret_cast<const char*>(records_.data()),
+                  records_.size() * sizeof(MemoryTraceRecord));
+    records_.clear();
   }
 };
 
-using MemorySegmentHeap =
-MaxHeap<MemorySegmentIterator, MemorySegmentSizeCompare>;
+struct MemoryTrace {
+  size_t memory_size;
+  std::vector<MemoryTraceRecord> records;
+};
+
+MemoryTrace ReadMemoryTrace(const std::string& path) {
+  std::ifstream stream(path, std::ios::binary | std::ios::ate);
+  if (!stream) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  size_t file_size = stream.tellg();
+  stream.seekg(0);
+  MemoryTraceHeader header;
+  if (file_size < sizeof(header) ||
+      !stream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    throw std::runtime_error("Trace " + path + " is truncated");
+  }
+  if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+    throw std::runtime_error(path + " is not a memory manager trace");
+  }
+  if (header.version != TRACE_VERSION || header.record_size != sizeof(MemoryTraceRecord)) {
+    throw std::runtime_error("Unsupported trace version " + std::to_string(header.version));
+  }
+  if ((file_size - sizeof(header)) % sizeof(MemoryTraceRecord) != 0) {
+    throw std::runtime_error("Trace " + path + " has inconsistent size");
+  }
+  MemoryTrace trace{header.memory_size,
+                    std::vector<MemoryTraceRecord>((file_size - sizeof(header)) /
+                                                   sizeof(MemoryTraceRecord))};
+  stream.read(reinterpret_cast<char*>(trace.records.data()),
+              trace.records.size() * sizeof(MemoryTraceRecord));
+  if (!stream) {
+    throw std::runtime_error("Cannot read trace " + path);
+  }
+  return trace;
+}
+
+/*
+ * Запись трассы подключается параметром шаблона MemoryManager, как
+ * наблюдатель в IndexedHeap: по умолчанию это пустой NoTraceRecorder,
+ * вызовы которого компилятор выбрасывает целиком.
+ */
+
+struct NoTraceRecorder {
+  void RecordAllocate(uint32_t /* segment */, size_t /* size */, size_t /* position */) const {
+  }
 
-struct MemorySegmentsHeapObserver {
-  void operator()(const MemorySegmentIterator& segment, size_t new_index) const {
-    segment->heap_index = new_index;
+  void RecordFree(uint32_t /* segment */, size_t /* size */, size_t /* position */) const {
   }
 };
 
-MemorySegment::MemorySegment(size_t left_, size_t right_):
-    left(left_),
-    right(right_),
-    heap_index(MemorySegmentHeap::kNullIndex)
-{}
+struct BinaryTraceRecorder {
+  MemoryTraceWriter* trace_writer;
+
+  void RecordAllocate(uint32_t segment, size_t size, size_t position) const {
+    trace_writer->RecordAllocate(segment, size, position);
+  }
+
+  void RecordFree(uint32_t segment, size_t size, size_t position) const {
+    trace_writer->RecordFree(segment, size, position);
+  }
+};
 
 /*
- * Мы храним сегменты в виде двусвязного списка (std::list).
- * Быстрый доступ к самому левому из наидлиннейших свободных отрезков
- * осуществляется с помощью кучи, в которой (во избежание дублирования
- * отрезков в памяти) хранятся итераторы на список — std::list::iterator.
- * Чтобы быстро определять местоположение сегмента в куче для его изменения,
- * мы внутри сегмента в списке храним heap_index, актуальность которого
- * поддерживаем с помощью index_change_observer. Мы не храним отдельной метки
- * для маркировки занятых сегментов: вместо этого мы кладём в heap_index
- * специальный kNullIndex. Более того, мы скрываем истинный тип
- * MemorySegmentIterator за названием SegmentHandle. Таким образом,
- * пользовательский
- * код абсолютно не зависит того, что мы храним сегменты в списке и в куче,
- * что позволяет нам легко поменять реализацию класса.
+ * Мы храним сегменты в виде интрузивного двусвязного списка: соседи
+ * сегмента записаны в его полях prev и next номерами ячеек пула.
+ * Выбор свободного сегмента под запрос делегирован политике размещения
+ * AllocationPolicy; по умолчанию это самый левый из наидлиннейших
+ * свободных отрезков. Свободные сегменты помечены флагом free, по
+ * которому при освобождении решается, склеивать ли сегмент с соседом.
+ * Номер сегмента скрыт внутри непрозрачного SegmentHandle. Таким образом,
+ * пользовательский код абсолютно не зависит того, как мы храним сегменты,
+ * что позволяет нам легко поменять реализацию класса. Каждый вызов
+ * Allocate и Free сообщается TraceRecorder.
 */
 
+template <class AllocationPolicy = WorstFitPolicy, class TraceRecorder = NoTraceRecorder>
 class MemoryManager {
  public:
-  using SegmentHandle = MemorySegmentIterator;
+  class SegmentHandle {
+   public:
+    SegmentHandle(): index_(NULL_SEGMENT)
+    {}
 
-  explicit MemoryManager(size_t memory_size):
-      free_memory_segments_(MemorySegmentHeap(MemorySegmentSizeCompare(),
-                                              MemorySegmentsHeapObserver())) {
-    memory_segments_.push_back(MemorySegment(1, memory_size + 1));
-    free_memory_segments_.Push(memory_segments_.begin());
+    bool operator==(const SegmentHandle& other) const {
+      return index_ == other.index_;
+    }
+
+    bool operator!=(const SegmentHandle& other) const {
+      return index_ != other.index_;
+    }
+
+   private:
+    friend class MemoryManager;
+
+    explicit SegmentHandle(uint32_t index): index_(index)
+    {}
+
+    uint32_t index_;
+  };
+
+  explicit MemoryManager(size_t memory_size, TraceRecorder trace_recorder = TraceRecorder()):
+      free_memory_segments_(&memory_segments_),
+      trace_recorder_(trace_recorder) {
+    auto segment = memory_segments_.Create(1, memory_size + 1);
+    memory_segments_[segment].free = true;
+    free_memory_segments_.Insert(segment);
   }
 
+  MemoryManager(const MemoryManager&) = delete;
+  MemoryManager& operator=(const MemoryManager&) = delete;
+
   SegmentHandle Allocate(size_t size) {
-    if (free_memory_segments_.size() == 0) {
+    auto fitting_segment = free_memory_segments_.Find(size);
+    if (fitting_segment == NULL_SEGMENT) {
+      trace_recorder_.RecordAllocate(NULL_SEGMENT, size, 0);
       return undefined_handle();
     }
-    auto max_size_segment_iterator = free_memory_segments_.top();
-    if (max_size_segment_iterator->size() < size) {
-      return undefined_handle();
-    }
-    auto max_left = max_size_segment_iterator->left;
-    auto allocated_segment = MemorySegment(max_left, max_left + size);
-    auto allocated_iterator = memory_segments_.insert(max_size_segment_iterator, allocated_segment);
-    free_memory_segments_.Pop();
-    if (max_size_segment_iterator->size() != size) {
-      max_size_segment_iterator->left += size;
-      free_memory_segments_.Push(max_size_segment_iterator);
+    auto fitting_left = memory_segments_[fitting_segment].left;
+    auto allocated_segment = memory_segments_.Create(fitting_left, fitting_left + size);
+    InsertBefore(fitting_segment, allocated_segment);
+    free_memory_segments_.Erase(fitting_segment);
+    if (memory_segments_[fitting_segment].size() != size) {
+      memory_segments_[fitting_segment].left += size;
+      free_memory_segments_.Insert(fitting_segment);
     } else {
-      memory_segments_.erase(max_size_segment_iterator);
+      Erase(fitting_segment);
     }
-    return allocated_iterator;
+    trace_recorder_.RecordAllocate(allocated_segment, size, fitting_left);
+    return SegmentHandle(allocated_segment);
   }
 
   void Free(SegmentHandle segment_handle) {
-    if (segment_handle != std::prev(memory_segments_.end())) {
-      AppendIfFree(segment_handle, std::next(segment_handle));
+    auto segment = segment_handle.index_;
+    trace_recorder_.RecordFree(segment, memory_segments_[segment].size(),
+                               memory_segments_[segment].left);
+    if (memory_segments_[segment].next != NULL_SEGMENT) {
+      AppendIfFree(segment, memory_segments_[segment].next);
     }
-    if (segment_handle != memory_segments_.begin()) {
-      AppendIfFree(segment_handle, std::prev(segment_handle));
+    if (memory_segments_[segment].prev != NULL_SEGMENT) {
+      AppendIfFree(segment, memory_segments_[segment].prev);
     }
-    free_memory_segments_.Push(segment_handle);
+    memory_segments_[segment].free = true;
+    free_memory_segments_.Insert(segment);
   }
 
-  SegmentHandle undefined_handle() {
-    return memory_segments_.end();
+  SegmentHandle undefined_handle() const {
+    return SegmentHandle();
+  }
+
+  size_t GetPosition(SegmentHandle segment_handle) const {
+    return memory_segments_[segment_handle.index_].left;
+  }
+
+  size_t LargestFreeSize() const {
+    return free_memory_segments_.LargestFreeSize();
   }
 
  private:
-  MemorySegmentHeap free_memory_segments_;
-  std::list<MemorySegment> memory_segments_;
+  MemorySegmentPool memory_segments_;
+  AllocationPolicy free_memory_segments_;
+  TraceRecorder trace_recorder_;
 
-  void AppendIfFree(SegmentHandle remaining, SegmentHandle appending) {
-    if (appending->heap_index != MemorySegmentHeap::kNullIndex) {
-      free_memory_segments_.Erase(appending->heap_index);
-      (*remaining) = remaining->Unite(*appending);
-      memory_segments_.erase(appending);
+  void InsertBefore(uint32_t position, uint32_t segment) {
+    auto prev = memory_segments_[position].prev;
+    memory_segments_[segment].prev = prev;
+    memory_segments_[segment].next = position;
+    memory_segments_[position].prev = segment;
+    if (prev != NULL_SEGMENT) {
+      memory_segments_[prev].next = segment;
+    }
+  }
+
+  void Erase(uint32_t segment) {
+    auto prev = memory_segments_[segment].prev;
+    auto next = memory_segments_[segment].next;
+    if (prev != NULL_SEGMENT) {
+      memory_segments_[prev].next = next;
+    }
+    if (next != NULL_SEGMENT) {
+      memory_segments_[next].prev = prev;
+    }
+    memory_segments_.Destroy(segment);
+  }
+
+  void AppendIfFree(uint32_t remaining, uint32_t appending) {
+    if (memory_segments_[appending].free) {
+      free_memory_segments_.Erase(appending);
+      memory_segments_[remaining].Absorb(memory_segments_[appending]);
+      Erase(appending);
     }
   }
 };
 
-size_t ReadMemorySize(std::istream& stream = std::cin) {
-  size_t memory_size;
-  stream >> memory_size;
-  return memory_size;
+/*
+ * Выделенный отрезок памяти вместе с его позицией и длиной: позицию нельзя
+ * спросить у менеджера позже без блокировки, поэтому она запоминается
+ * в момент выделения. Неудачному выделению соответствует пустой handle.
+ */
+
+template <class AllocationPolicy>
+struct MemoryBlock {
+  using SegmentHandle = typename MemoryManager<AllocationPolicy>::SegmentHandle;
+
+  SegmentHandle handle;
+  size_t position;
+  size_t size;
+
+  bool allocated() const {
+    return handle != SegmentHandle();
+  }
+};
+
+/*
+ * Потокобезопасная обёртка, в которой каждая операция берёт один общий
+ * мьютекс. Служит точкой отсчёта для ConcurrentMemoryManager.
+ */
+
+template <class AllocationPolicy = WorstFitPolicy>
+class LockedMemoryManager {
+ public:
+  using Block = MemoryBlock<AllocationPolicy>;
+
+  explicit LockedMemoryManager(size_t memory_size): memory_manager_(memory_size)
+  {}
+
+  Block Allocate(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto handle = memory_manager_.Allocate(size);
+    if (handle == memory_manager_.undefined_handle()) {
+      return Block{handle, 0, size};
+    }
+    return Block{handle, memory_manager_.GetPosition(handle), size};
+  }
+
+  void Free(const Block& block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_manager_.Free(block.handle);
+  }
+
+ private:
+  std::mutex mutex_;
+  MemoryManager<AllocationPolicy> memory_manager_;
+};
+
+constexpr size_t SMALL_SIZE_CLASSES_COUNT = 8;
+constexpr size_t SMALL_SEGMENT_MAX_SIZE = size_t(1) << (SMALL_SIZE_CLASSES_COUNT - 1);
+constexpr size_t THREAD_CACHE_BATCH_SIZE = 32;
+constexpr size_t THREAD_CACHE_MAX_SIZE = 2 * THREAD_CACHE_BATCH_SIZE;
+
+/*
+ * Многопоточный менеджер памяти. Малые запросы (не длиннее
+ * SMALL_SEGMENT_MAX_SIZE) округляются вверх до степени двойки и
+ * обслуживаются из кеша потока ThreadCache без всякой синхронизации.
+ * Пустой список кеша пополняется пачкой из THREAD_CACHE_BATCH_SIZE
+ * отрезков за один захват блокировки центрального менеджера, а при
+ * переполнении списка пачка отрезков так же одним захватом возвращается
+ * обратно, где они склеиваются с соседями. Большие запросы идут напрямую
+ * в центральный менеджер, и блокировка держится только на время одного
+ * Allocate или Free. Отрезок, освобождённый не тем потоком, который его
+ * выделил, просто попадает в кеш освободившего потока.
+ */
+
+template <class AllocationPolicy = WorstFitPolicy>
+class ConcurrentMemoryManager {
+ public:
+  using Block = MemoryBlock<AllocationPolicy>;
+
+  class ThreadCache {
+   public:
+    explicit ThreadCache(ConcurrentMemoryManager* owner): owner_(owner)
+    {}
+
+    ThreadCache(const ThreadCache&) = delete;
+    ThreadCache& operator=(const ThreadCache&) = delete;
+
+    ~ThreadCache() {
+      for (auto& blocks: cached_blocks_) {
+        owner_->ReturnBatch(blocks, blocks.size());
+      }
+    }
+
+    Block Allocate(size_t size) {
+      if (size > SMALL_SEGMENT_MAX_SIZE) {
+        return owner_->AllocateCentral(size);
+      }
+      auto& blocks = cached_blocks_[SizeClass(size)];
+      if (blocks.empty()) {
+        owner_->Refill(SizeClass(size), blocks);
+        if (blocks.empty()) {
+          return Block{typename Block::SegmentHandle(), 0, size};
+        }
+      }
+      auto block = blocks.back();
+      blocks.pop_back();
+      return block;
+    }
+
+    void Free(const Block& block) {
+      if (block.size > SMALL_SEGMENT_MAX_SIZE) {
+        owner_->FreeCentral(block);
+        return;
+      }
+      auto& blocks = cached_blocks_[SizeClass(block.size)];
+      blocks.push_back(block);
+      if (blocks.size() > THREAD_CACHE_MAX_SIZE) {
+        owner_->ReturnBatch(blocks, THREAD_CACHE_BATCH_SIZE);
+      }
+    }
+
+   private:
+    ConcurrentMemoryManager* owner_;
+    std::vector<Block> cached_blocks_[SMALL_SIZE_CLASSES_COUNT];
+
+    static size_t SizeClass(size_t size) {
+      return size <= 1 ? 0 : 64 - __builtin_clzll(size - 1);
+    }
+  };
+
+  explicit ConcurrentMemoryManager(size_t memory_size): memory_manager_(memory_size)
+  {}
+
+  ConcurrentMemoryManager(const ConcurrentMemoryManager&) = delete;
+  ConcurrentMemoryManager& operator=(const ConcurrentMemoryManager&) = delete;
+
+ private:
+  std::mutex mutex_;
+  MemoryManager<AllocationPolicy> memory_manager_;
+
+  Block AllocateCentral(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return AllocateLocked(size);
+  }
+
+  void FreeCentral(const Block& block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_manager_.Free(block.handle);
+  }
+
+  void Refill(size_t size_class, std::vector<Block>& blocks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < THREAD_CACHE_BATCH_SIZE; ++i) {
+      auto block = AllocateLocked(size_t(1) << size_class);
+      if (!block.allocated()) {
+        break;
+      }
+      blocks.push_back(block);
+    }
+  }
+
+  void ReturnBatch(std::vector<Block>& blocks, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < count; ++i) {
+      memory_manager_.Free(blocks.back().handle);
+      blocks.pop_back();
+    }
+  }
+
+  Block AllocateLocked(size_t size) {
+    auto handle = memory_manager_.Allocate(size);
+    if (handle == memory_manager_.undefined_handle()) {
+      return Block{handle, 0, size};
+    }
+    return Block{handle, memory_manager_.GetPosition(handle), size};
+  }
+};
+
+size_t ReadMemorySize(FastReader& reader) {
+  return reader.ReadInteger<size_t>();
 }
 
 struct AllocationQuery {
@@ -275,62 +969,41 @@ struct FreeQuery {
  * Для хранения запросов используется специальный класс-обёртка
  * MemoryManagerQuery. Фишка данной реализации в том, что мы можем удобно
  * положить в него любой запрос, при этом у нас есть методы, которые позволят
- * гарантированно правильно проинтерпретировать его содержимое. При реализации
- * нужно воспользоваться тем фактом, что dynamic_cast возвращает nullptr
- * при неудачном приведении указателей.
+ * гарантированно правильно проинтерпретировать его содержимое. Запрос
+ * хранится прямо внутри обёртки в std::variant, поэтому вектор запросов
+ * лежит в памяти сплошным куском без отдельного выделения на каждый
+ * запрос, а тип определяется по метке варианта без RTTI.
 */
 
 class MemoryManagerQuery {
  public:
   explicit MemoryManagerQuery(AllocationQuery allocation_query) :
-      query_(new ConcreteQuery<AllocationQuery>(allocation_query)) {
+      query_(allocation_query) {
   }
 
   explicit MemoryManagerQuery(FreeQuery free_query) :
-      query_(new ConcreteQuery<FreeQuery>(free_query)) {
+      query_(free_query) {
   }
 
   const AllocationQuery* AsAllocationQuery() const {
-    auto ptr = dynamic_cast<ConcreteQuery<AllocationQuery>*>(query_.get());
-    if (ptr) {
-      return &(ptr)->body;
-    } else {
-      return nullptr;
-    }
+    return std::get_if<AllocationQuery>(&query_);
   }
 
   const FreeQuery* AsFreeQuery() const {
-    auto ptr = dynamic_cast<ConcreteQuery<FreeQuery>*>(query_.get());
-    return (ptr) ? &(ptr)->body : nullptr;
+    return std::get_if<FreeQuery>(&query_);
   }
 
  private:
-  class AbstractQuery {
-   public:
-    virtual ~AbstractQuery() {}
-
-   protected:
-    AbstractQuery() {}
-  };
-
-  template <typename T>
-  struct ConcreteQuery : public AbstractQuery {
-    T body;
-
-    explicit ConcreteQuery(T _body) : body(std::move(_body)) {}
-  };
-
-  std::unique_ptr<AbstractQuery> query_;
+  std::variant<AllocationQuery, FreeQuery> query_;
 };
 
 
-std::vector<MemoryManagerQuery> ReadMemoryManagerQueries(std::istream& stream = std::cin) {
-  int queries_count;
-  stream >> queries_count;
-  int number;
+std::vector<MemoryManagerQuery> ReadMemoryManagerQueries(FastReader& reader) {
+  int queries_count = reader.ReadInteger();
   std::vector<MemoryManagerQuery> queries_vector;
+  queries_vector.reserve(queries_count);
   for (int i = 0; i < queries_count; ++i) {
-    std::cin >> number;
+    int number = reader.ReadInteger();
     if (number > 0) {
       queries_vector.emplace_back(AllocationQuery({static_cast<size_t>(number)}));
     } else {
@@ -353,11 +1026,14 @@ MemoryManagerAllocationResponse MakeFailedAllocation() {
   return {false, 0};
 }
 
+template <class AllocationPolicy, class TraceRecorder = NoTraceRecorder>
 std::vector<MemoryManagerAllocationResponse> RunMemoryManager(
-    size_t memory_size, const std::vector<MemoryManagerQuery>& queries) {
-  MemoryManager memory_manager(memory_size);
+    size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    TraceRecorder trace_recorder = TraceRecorder()) {
+  MemoryManager<AllocationPolicy, TraceRecorder> memory_manager(memory_size, trace_recorder);
   std::vector<MemoryManagerAllocationResponse> responses;
-  std::vector<MemoryManager::SegmentHandle> segments_iterators;
+  std::vector<typename MemoryManager<AllocationPolicy, TraceRecorder>::SegmentHandle>
+      segments_iterators;
   for (const auto &query: queries) {
     if (const auto* allocation_query = query.AsAllocationQuery()) {
       auto segment_iterator = memory_manager.Allocate(allocation_query->allocation_size);
@@ -365,7 +1041,8 @@ std::vector<MemoryManagerAllocationResponse> RunMemoryManager(
       if (segment_iterator == memory_manager.undefined_handle()) {
         responses.emplace_back(MakeFailedAllocation());
       } else {
-        responses.push_back(MakeSuccessfulAllocation((*segment_iterator).left));
+        responses.push_back(MakeSuccessfulAllocation(
+            memory_manager.GetPosition(segment_iterator)));
       }
     } else if (const auto* free_query = query.AsFreeQuery()) {
       auto segment_iterator = segments_iterators[free_query->allocation_query_index];
@@ -380,28 +1057,540 @@ std::vector<MemoryManagerAllocationResponse> RunMemoryManager(
   return responses;
 }
 
+/*
+ * Отчёт о политике размещения на данной последовательности запросов:
+ * число отказов, медиана и 99-й перцентиль времени Allocate и Free и
+ * длина наибольшего свободного сегмента, замеренная через равные
+ * промежутки по ходу обработки запросов.
+ */
+
+constexpr size_t REPORT_CHECKPOINTS_COUNT = 10;
+
+struct MemoryManagerPolicyReport {
+  size_t allocations_count = 0;
+  size_t failed_allocations_count = 0;
+  std::vector<uint64_t> allocate_nanoseconds;
+  std::vector<uint64_t> free_nanoseconds;
+  std::vector<size_t> largest_free_sizes;
+};
+
+template <class AllocationPolicy>
+MemoryManagerPolicyReport ProfileMemoryManager(
+    size_t memory_size, const std::vector<MemoryManagerQuery>& queries) {
+  using steady_clock = std::chrono::steady_clock;
+  MemoryManager<AllocationPolicy> memory_manager(memory_size);
+  MemoryManagerPolicyReport report;
+  std::vector<typename MemoryManager<AllocationPolicy>::SegmentHandle> segments_iterators;
+  size_t checkpoint_period = std::max<size_t>(1, queries.size() / REPORT_CHECKPOINTS_COUNT);
+  for (size_t i = 0; i < queries.size(); ++i) {
+    if (const auto* allocation_query = queries[i].AsAllocationQuery()) {
+      auto start = steady_clock::now();
+      auto segment_iterator = memory_manager.Allocate(allocation_query->allocation_size);
+      report.allocate_nanoseconds.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          steady_clock::now() - start).count());
+      ++report.allocations_count;
+      if (segment_iterator == memory_manager.undefined_handle()) {
+        ++report.failed_allocations_count;
+      }
+      segments_iterators.push_back(segment_iterator);
+    } else if (const auto* free_query = queries[i].AsFreeQuery()) {
+      auto segment_iterator = segments_iterators[free_query->allocation_query_index];
+      if (segment_iterator != memory_manager.undefined_handle()) {
+        auto start = steady_clock::now();
+        memory_manager.Free(segment_iterator);
+        report.free_nanoseconds.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            steady_clock::now() - start).count());
+      }
+      segments_iterators.push_back(memory_manager.undefined_handle());
+    }
+    if ((i + 1) % checkpoint_period == 0 || i + 1 == queries.size()) {
+      report.largest_free_sizes.push_back(memory_manager.LargestFreeSize());
+    }
+  }
+  return report;
+}
+
+uint64_t Percentile(std::vector<uint64_t>& values, double fraction) {
+  if (values.empty()) {
+    return 0;
+  }
+  auto position = values.begin() + static_cast<size_t>(fraction * (values.size() - 1));
+  std::nth_element(values.begin(), position, values.end());
+  return *position;
+}
+
+template <class AllocationPolicy>
+void WritePolicyReport(size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+                       FastWriter& writer) {
+  auto report = ProfileMemoryManager<AllocationPolicy>(memory_size, queries);
+  writer.WriteFormatted("%s: failed %zu of %zu allocations\n", AllocationPolicy::NAME,
+                        report.failed_allocations_count, report.allocations_count);
+  writer.WriteFormatted("  allocate p50 %llu ns, p99 %llu ns\n",
+                        static_cast<unsigned long long>(Percentile(report.allocate_nanoseconds, 0.5)),
+                        static_cast<unsigned long long>(Percentile(report.allocate_nanoseconds, 0.99)));
+  writer.WriteFormatted("  free p50 %llu ns, p99 %llu ns\n",
+                        static_cast<unsigned long long>(Percentile(report.free_nanoseconds, 0.5)),
+                        static_cast<unsigned long long>(Percentile(report.free_nanoseconds, 0.99)));
+  writer.WriteString("  largest free block:");
+  for (auto largest_free_size: report.largest_free_sizes) {
+    writer.WriteChar(' ');
+    writer.WriteInteger(largest_free_size);
+  }
+  writer.WriteChar('\n');
+}
+
+/*
+ * Гистограмма задержек по степеням двойки: строка на каждый непустой
+ * интервал [2^k, 2^(k+1)) наносекунд.
+ */
+
+void WriteLatencyHistogram(const char* operation_name, const std::vector<uint64_t>& nanoseconds,
+                           FastWriter& writer) {
+  std::vector<size_t> counts(64);
+  for (auto value: nanoseconds) {
+    ++counts[value == 0 ? 0 : 63 - __builtin_clzll(value)];
+  }
+  writer.WriteFormatted("%s latency histogram:\n", operation_name);
+  for (size_t power = 0; power < counts.size(); ++power) {
+    if (counts[power] != 0) {
+      writer.WriteFormatted("  [%llu, %llu) ns: %zu\n", 1ull << power, 2ull << power,
+                            counts[power]);
+    }
+  }
+}
+
+/*
+ * Превращает трассу в последовательность запросов того же вида, что и
+ * на входе программы: освобождение ссылается на номер запроса, которым
+ * было сделано соответствующее выделение.
+ */
+
+std::vector<MemoryManagerQuery> MemoryTraceToQueries(const MemoryTrace& trace) {
+  std::vector<MemoryManagerQuery> queries;
+  std::vector<size_t> allocation_query_indices;
+  queries.reserve(trace.records.size());
+  for (const auto& record: trace.records) {
+    if (record.operation == MemoryOperation::ALLOCATE) {
+      allocation_query_indices.push_back(queries.size());
+      queries.emplace_back(AllocationQuery({record.size}));
+    } else {
+      queries.emplace_back(FreeQuery({allocation_query_indices.at(record.allocation_id)}));
+    }
+  }
+  return queries;
+}
+
+/*
+ * Воспроизводит трассу с полной скоростью: пропускная способность
+ * RunMemoryManager, число выделений, позиция которых разошлась с
+ * записанной в трассе, кривая наибольшего свободного отрезка и
+ * гистограммы задержек Allocate и Free.
+ */
+
+template <class AllocationPolicy>
+void ReplayMemoryTrace(const std::string& path, FastWriter& writer) {
+  auto trace = ReadMemoryTrace(path);
+  auto queries = MemoryTraceToQueries(trace);
+
+  auto start = std::chrono::steady_clock::now();
+  auto responses = RunMemoryManager<AllocationPolicy>(trace.memory_size, queries);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  size_t diverged_count = 0;
+  size_t response_index = 0;
+  for (const auto& record: trace.records) {
+    if (record.operation == MemoryOperation::ALLOCATE) {
+      const auto& response = responses[response_index++];
+      if ((response.success ? response.position : 0) != record.position) {
+        ++diverged_count;
+      }
+    }
+  }
+  writer.WriteFormatted("%s: %zu operations in %.3f s, %.0f ops/sec\n", AllocationPolicy::NAME,
+                        queries.size(), elapsed.count(), queries.size() / elapsed.count());
+  writer.WriteFormatted("allocations diverged from trace: %zu of %zu\n",
+                        diverged_count, responses.size());
+
+  auto report = ProfileMemoryManager<AllocationPolicy>(trace.memory_size, queries);
+  writer.WriteString("largest free block:");
+  for (auto largest_free_size: report.largest_free_sizes) {
+    writer.WriteChar(' ');
+    writer.WriteInteger(largest_free_size);
+  }
+  writer.WriteChar('\n');
+  WriteLatencyHistogram("allocate", report.allocate_nanoseconds, writer);
+  WriteLatencyHistogram("free", report.free_nanoseconds, writer);
+}
+
 void OutputMemoryManagerResponses(
     const std::vector<MemoryManagerAllocationResponse>& responses,
-    std::ostream& ostream = std::cout) {
+    FastWriter& writer) {
   for (const auto &response: responses) {
     if (response.success) {
-      ostream << response.position << "\n";
+      writer.WriteInteger(response.position);
     } else {
-      ostream << "-1" << "\n";
+      writer.WriteString("-1", 2);
     }
+    writer.WriteChar('\n');
   }
 }
 
-int main() {
-  std::istream &input_stream = std::cin;
-  std::ostream &output_stream = std::cout;
+/*
+ * Нагрузочный режим: threads_count потоков поровну делят STRESS_OPERATIONS
+ * случайных выделений и освобождений в общей памяти. Девять из десяти
+ * запросов малые, остальные длиной до STRESS_MAX_LARGE_SIZE; каждый поток
+ * держит не больше STRESS_MAX_LIVE_BLOCKS отрезков одновременно.
+ */
+
+constexpr size_t STRESS_MEMORY_SIZE = size_t(1) << 30;
+constexpr int STRESS_OPERATIONS = 1 << 22;
+constexpr size_t STRESS_MAX_LARGE_SIZE = 1 << 12;
+constexpr size_t STRESS_MAX_LIVE_BLOCKS = 1 << 10;
+
+template <class Client>
+void RunStressWorker(Client& client, int thread_index, int operations_count) {
+  std::mt19937 generator(thread_index);
+  std::vector<decltype(client.Allocate(1))> live_blocks;
+  for (int i = 0; i < operations_count; ++i) {
+    if (live_blocks.empty() ||
+        (live_blocks.size() < STRESS_MAX_LIVE_BLOCKS && generator() % 2 == 0)) {
+      size_t size = generator() % 10 == 0 ?
+          1 + generator() % STRESS_MAX_LARGE_SIZE : 1 + generator() % SMALL_SEGMENT_MAX_SIZE;
+      auto block = client.Allocate(size);
+      if (block.allocated()) {
+        live_blocks.push_back(block);
+      }
+    } else {
+      auto index = generator() % live_blocks.size();
+      client.Free(live_blocks[index]);
+      live_blocks[index] = live_blocks.back();
+      live_blocks.pop_back();
+    }
+  }
+  for (const auto& block: live_blocks) {
+    client.Free(block);
+  }
+}
+
+template <class Worker>
+double TimeStressThreads(int threads_count, Worker worker) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < threads_count; ++thread_index) {
+    threads.emplace_back(worker, thread_index);
+  }
+  for (auto& thread: threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return STRESS_OPERATIONS / elapsed.count();
+}
+
+double RunLockedStress(int threads_count) {
+  LockedMemoryManager<> memory_manager(STRESS_MEMORY_SIZE);
+  return TimeStressThreads(threads_count, [&](int thread_index) {
+    RunStressWorker(memory_manager, thread_index, STRESS_OPERATIONS / threads_count);
+  });
+}
+
+double RunConcurrentStress(int threads_count) {
+  ConcurrentMemoryManager<> memory_manager(STRESS_MEMORY_SIZE);
+  return TimeStressThreads(threads_count, [&](int thread_index) {
+    ConcurrentMemoryManager<>::ThreadCache thread_cache(&memory_manager);
+    RunStressWorker(thread_cache, thread_index, STRESS_OPERATIONS / threads_count);
+  });
+}
+
+void WriteStressReport(FastWriter& writer) {
+  int max_threads = std::max(4u, std::thread::hardware_concurrency());
+  for (int threads_count = 1; ; threads_count = std::min(2 * threads_count, max_threads)) {
+    writer.WriteFormatted("%d threads: global mutex %.0f ops/sec, thread caches %.0f ops/sec\n",
+                          threads_count, RunLockedStress(threads_count),
+                          RunConcurrentStress(threads_count));
+    if (threads_count == max_threads) {
+      break;
+    }
+  }
+}
+
+/*
+ * Бенчмарк (--bench) воспроизводит BENCHMARK_QUERIES_COUNT случайных
+ * запросов на прежнем менеджере поверх std::list и на нынешнем с пулом
+ * сегментов и печатает пропускную способность и число выделений в куче
+ * за время воспроизведения. Выделения считает заменённый глобальный
+ * operator new, пока поднят heap_allocations_counting; векторы ответов
+ * и handle'ов резервируются заранее, так что в счёт идут только
+ * выделения самих менеджеров.
+ */
+
+std::atomic<bool> heap_allocations_counting(false);
+std::atomic<size_t> heap_allocations_count(0);
+
+__attribute__((noinline)) void* operator new(size_t size) {
+  if (heap_allocations_counting.load(std::memory_order_relaxed)) {
+    heap_allocations_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  void* pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void* pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+/*
+ * Прежнее устройство менеджера для сравнения: сегменты в std::list, куча
+ * итераторов на самый левый из наидлиннейших свободных, так что каждое
+ * разбиение и слияние выделяет или освобождает узел списка.
+ */
+
+class ListMemoryManager {
+ public:
+  struct Segment {
+    size_t left;
+    size_t right;
+    size_t heap_index;
+
+    size_t size() const {
+      return right - left;
+    }
+  };
+
+  using SegmentHandle = std::list<Segment>::iterator;
+
+  explicit ListMemoryManager(size_t memory_size) {
+    memory_segments_.push_back(Segment{1, memory_size + 1, Heap::kNullIndex});
+    free_memory_segments_.Push(memory_segments_.begin());
+  }
+
+  SegmentHandle Allocate(size_t size) {
+    if (free_memory_segments_.size() == 0 || free_memory_segments_.top()->size() < size) {
+      return undefined_handle();
+    }
+    auto fitting_segment = free_memory_segments_.top();
+    auto fitting_left = fitting_segment->left;
+    auto allocated_segment = memory_segments_.insert(
+        fitting_segment, Segment{fitting_left, fitting_left + size, Heap::kNullIndex});
+    free_memory_segments_.Pop();
+    if (fitting_segment->size() != size) {
+      fitting_segment->left += size;
+      free_memory_segments_.Push(fitting_segment);
+    } else {
+      memory_segments_.erase(fitting_segment);
+    }
+    return allocated_segment;
+  }
+
+  void Free(SegmentHandle segment) {
+    if (segment != std::prev(memory_segments_.end())) {
+      AppendIfFree(segment, std::next(segment));
+    }
+    if (segment != memory_segments_.begin()) {
+      AppendIfFree(segment, std::prev(segment));
+    }
+    free_memory_segments_.Push(segment);
+  }
+
+  SegmentHandle undefined_handle() {
+    return memory_segments_.end();
+  }
+
+  size_t GetPosition(SegmentHandle segment) const {
+    return segment->left;
+  }
+
+ private:
+  struct SizeCompare {
+    bool operator()(SegmentHandle first, SegmentHandle second) const {
+      if (first->size() == second->size()) {
+        return first->left >= second->left;
+      }
+      return first->size() < second->size();
+    }
+  };
+
+  struct HeapObserver {
+    void operator()(SegmentHandle segment, size_t new_index) const {
+      segment->heap_index = new_index;
+    }
+  };
 
-  const size_t memory_size = ReadMemorySize(input_stream);
+  using Heap = IndexedHeap<SegmentHandle, SizeCompare, HeapObserver, 4>;
+
+  Heap free_memory_segments_;
+  std::list<Segment> memory_segments_;
+
+  void AppendIfFree(SegmentHandle remaining, SegmentHandle appending) {
+    if (appending->heap_index != Heap::kNullIndex) {
+      free_memory_segments_.Erase(appending->heap_index);
+      remaining->left = std::min(remaining->left, appending->left);
+      remaining->right = std::max(remaining->right, appending->right);
+      memory_segments_.erase(appending);
+    }
+  }
+};
+
+constexpr size_t BENCHMARK_MEMORY_SIZE = size_t(1) << 32;
+constexpr size_t BENCHMARK_QUERIES_COUNT = 10000000;
+constexpr size_t BENCHMARK_MAX_ALLOCATION_SIZE = 1 << 12;
+
+/*
+ * Случайная смесь запросов: с вероятностью 0.45 освобождается случайный
+ * ещё не освобождённый отрезок, иначе выделяется отрезок длиной до
+ * BENCHMARK_MAX_ALLOCATION_SIZE, так что число живых отрезков растёт
+ * примерно до 10^6.
+ */
+std::vector<MemoryManagerQuery> GenerateBenchmarkQueries() {
+  std::mt19937_64 generator(0);
+  std::vector<MemoryManagerQuery> queries;
+  queries.reserve(BENCHMARK_QUERIES_COUNT);
+  std::vector<size_t> live_allocations;
+  for (size_t i = 0; i < BENCHMARK_QUERIES_COUNT; ++i) {
+    if (!live_allocations.empty() && generator() % 100 < 45) {
+      auto index = generator() % live_allocations.size();
+      queries.emplace_back(FreeQuery({live_allocations[index]}));
+      live_allocations[index] = live_allocations.back();
+      live_allocations.pop_back();
+    } else {
+      queries.emplace_back(AllocationQuery({1 + generator() % BENCHMARK_MAX_ALLOCATION_SIZE}));
+      live_allocations.push_back(i);
+    }
+  }
+  return queries;
+}
+
+template <class Manager>
+void WriteManagerBenchmark(const char* name, const std::vector<MemoryManagerQuery>& queries,
+                           FastWriter& writer) {
+  Manager memory_manager(BENCHMARK_MEMORY_SIZE);
+  std::vector<typename Manager::SegmentHandle> segments_handles;
+  segments_handles.reserve(queries.size());
+  size_t failed_count = 0;
+  uint64_t checksum = 0;
+  heap_allocations_count.store(0);
+  heap_allocations_counting.store(true);
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &query: queries) {
+    if (const auto* allocation_query = query.AsAllocationQuery()) {
+      auto segment_handle = memory_manager.Allocate(allocation_query->allocation_size);
+      segments_handles.push_back(segment_handle);
+      if (segment_handle == memory_manager.undefined_handle()) {
+        ++failed_count;
+      } else {
+        checksum = checksum * 1000003 + memory_manager.GetPosition(segment_handle);
+      }
+    } else {
+      auto segment_handle = segments_handles[query.AsFreeQuery()->allocation_query_index];
+      if (segment_handle != memory_manager.undefined_handle()) {
+        memory_manager.Free(segment_handle);
+      }
+      segments_handles.push_back(memory_manager.undefined_handle());
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  heap_allocations_counting.store(false);
+  writer.WriteFormatted("%s: %.0f queries/sec, %zu heap allocations, %zu failed, "
+                        "checksum %llx\n", name, queries.size() / elapsed.count(),
+                        heap_allocations_count.load(), failed_count,
+                        static_cast<unsigned long long>(checksum));
+}
+
+void WriteBenchmark(FastWriter& writer) {
+  auto queries = GenerateBenchmarkQueries();
+  writer.WriteFormatted("%zu queries\n", queries.size());
+  WriteManagerBenchmark<ListMemoryManager>("std::list segments", queries, writer);
+  WriteManagerBenchmark<MemoryManager<>>("pooled segments", queries, writer);
+}
+
+struct ProgramOptions {
+  std::string policy = WorstFitPolicy::NAME;
+  std::string trace_path;
+  std::string replay_path;
+  bool write_report = false;
+  bool write_stress_report = false;
+  bool write_benchmark = false;
+};
+
+ProgramOptions ParseProgramOptions(int argc, char* argv[]) {
+  ProgramOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string option = argv[i];
+    if (option == "--report") {
+      options.write_report = true;
+    } else if (option == "--stress") {
+      options.write_stress_report = true;
+    } else if (option == "--bench") {
+      options.write_benchmark = true;
+    } else if (option == "--policy" && i + 1 < argc) {
+      options.policy = argv[++i];
+    } else if (option == "--trace" && i + 1 < argc) {
+      options.trace_path = argv[++i];
+    } else if (option == "--replay" && i + 1 < argc) {
+      options.replay_path = argv[++i];
+    } else {
+      throw std::invalid_argument("Unknown option " + option);
+    }
+  }
+  return options;
+}
+
+template <class AllocationPolicy>
+void RunWithPolicy(const ProgramOptions& options, FastWriter& writer) {
+  if (!options.replay_path.empty()) {
+    ReplayMemoryTrace<AllocationPolicy>(options.replay_path, writer);
+    return;
+  }
+  FastReader reader;
+  const size_t memory_size = ReadMemorySize(reader);
   const std::vector<MemoryManagerQuery> queries =
-      ReadMemoryManagerQueries(input_stream);
-  const std::vector<MemoryManagerAllocationResponse> responses =
-      RunMemoryManager(memory_size, queries);
+      ReadMemoryManagerQueries(reader);
+  if (options.trace_path.empty()) {
+    OutputMemoryManagerResponses(RunMemoryManager<AllocationPolicy>(memory_size, queries), writer);
+    return;
+  }
+  MemoryTraceWriter trace_writer(options.trace_path, memory_size);
+  OutputMemoryManagerResponses(RunMemoryManager<AllocationPolicy>(
+      memory_size, queries, BinaryTraceRecorder{&trace_writer}), writer);
+  trace_writer.Close();
+}
 
-  OutputMemoryManagerResponses(responses, output_stream);
+int main(int argc, char* argv[]) {
+  auto options = ParseProgramOptions(argc, argv);
+  FastWriter writer;
+  if (options.write_stress_report) {
+    WriteStressReport(writer);
+    return 0;
+  }
+  if (options.write_benchmark) {
+    WriteBenchmark(writer);
+    return 0;
+  }
+  if (options.write_report) {
+    FastReader reader;
+    const size_t memory_size = ReadMemorySize(reader);
+    const std::vector<MemoryManagerQuery> queries =
+        ReadMemoryManagerQueries(reader);
+    WritePolicyReport<WorstFitPolicy>(memory_size, queries, writer);
+    WritePolicyReport<BestFitPolicy>(memory_size, queries, writer);
+    WritePolicyReport<FirstFitPolicy>(memory_size, queries, writer);
+    WritePolicyReport<SegregatedFitPolicy>(memory_size, queries, writer);
+  } else if (options.policy == WorstFitPolicy::NAME) {
+    RunWithPolicy<WorstFitPolicy>(options, writer);
+  } else if (options.policy == BestFitPolicy::NAME) {
+    RunWithPolicy<BestFitPolicy>(options, writer);
+  } else if (options.policy == FirstFitPolicy::NAME) {
+    RunWithPolicy<FirstFitPolicy>(options, writer);
+  } else if (options.policy == SegregatedFitPolicy::NAME) {
+    RunWithPolicy<SegregatedFitPolicy>(options, writer);
+  } else {
+    throw std::invalid_argument("Unknown allocation policy " + options.policy);
+  }
   return 0;
 }
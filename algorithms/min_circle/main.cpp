@@ -1,12 +1,24 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../common/fast_io.h"
 
 constexpr double MAX_RADIUS = 2000;
 constexpr double PRECISION = 0.001;
-constexpr double MAX_BORDER = 4000;
+constexpr int RADIX_BITS = 8;
+constexpr size_t RADIX_BUCKETS = size_t(1) << RADIX_BITS;
+constexpr int RADIX_PASSES = 64 / RADIX_BITS;
+
+using DoubleVector = double __attribute__((vector_size(16)));
+constexpr size_t DOUBLE_VECTOR_SIZE = sizeof(DoubleVector) / sizeof(double);
 
 struct Point {
   int x_coordinate;
@@ -18,83 +30,155 @@ struct Point {
   Point() {}
 };
 
-struct Segment {
-  double begin;
-  double end;
-  Segment(double begin_, double end_): begin(begin_), end(end_) {}
-  Segment() {}
-};
-
-struct BorderPoint {
-  double coordinate = 0;
-  std::string type;
-  BorderPoint() {}
-  BorderPoint(double coordinate_, std::string type_): coordinate(coordinate_), type(type_) {}
-};
-
-class BorderPointComparator {
- public:
-  bool operator()(const BorderPoint& first, const BorderPoint& second) {
-    if (first.coordinate == second.coordinate && first.type == second.type) {
-      return false;
-    }
-    return first.coordinate <= second.coordinate;
-  }
-};
-
-std::vector<Point> read_points(int number_of_points, std::istream& input_stream = std::cin) {
+std::vector<Point> read_points(int number_of_points, FastReader& reader) {
   std::vector<Point> points;
+  points.reserve(number_of_points);
   for (int i = 0 ; i < number_of_points; ++i) {
-    int x_coordinate, y_coordinate;
-    input_stream >> x_coordinate;
-    input_stream >> y_coordinate;
+    int x_coordinate = reader.ReadInteger();
+    int y_coordinate = reader.ReadInteger();
     points.emplace_back(Point(x_coordinate, y_coordinate));
   }
   return points;
 }
 
-Segment intersect_circle_with_axes(Point center, double radius) {
-  double temp = radius * radius - center.y_coordinate * center.y_coordinate;
-  if (temp < 0) {
-    return Segment(MAX_BORDER, MAX_BORDER);
+DoubleVector load_vector(const double* values) {
+  DoubleVector vector;
+  std::memcpy(&vector, values, sizeof(vector));
+  return vector;
+}
+
+void store_vector(double* values, DoubleVector vector) {
+  std::memcpy(values, &vector, sizeof(vector));
+}
+
+DoubleVector vector_sqrt(DoubleVector values) {
+#ifdef __SSE2__
+  return _mm_sqrt_pd(values);
+#else
+  for (size_t lane = 0; lane < DOUBLE_VECTOR_SIZE; ++lane) {
+    values[lane] = std::sqrt(values[lane]);
   }
-  temp = std::pow(temp, 0.5);
-  return Segment(center.x_coordinate - temp, center.x_coordinate + temp);
+  return values;
+#endif
 }
 
-double find_minimal_covering_radius(const std::vector<Point>& points,
-                                    int number_of_covered_points) {
-  double insufficient_radius = 0;
-  double approved_radius = MAX_RADIUS;
-  while (approved_radius - insufficient_radius >= PRECISION) {
-    auto current_radius = (approved_radius - insufficient_radius) / 2 + insufficient_radius;
-    std::vector<BorderPoint> border_points;
-    for (auto &point: points) {
-      auto segment = intersect_circle_with_axes(point, current_radius);
-      if (segment.begin != MAX_BORDER) {
-        border_points.emplace_back(BorderPoint(segment.begin, "left"));
+/*
+ * Граница отрезка упакована в одно 64-битное число: биты double
+ * переставлены так, что порядок чисел совпадает с порядком координат,
+ * а младший бит мантиссы заменён типом границы (0 — левая, 1 — правая).
+ * Поэтому при равных координатах левые границы идут раньше правых,
+ * и касающиеся отрезки считаются пересекающимися.
+ */
+uint64_t encode_border_point(double coordinate, uint64_t is_right) {
+  uint64_t bits;
+  std::memcpy(&bits, &coordinate, sizeof(bits));
+  uint64_t flip = (0 - (bits >> 63)) | (uint64_t(1) << 63);
+  return ((bits ^ flip) & ~uint64_t(1)) | is_right;
+}
+
+/*
+ * Проверка «найдётся ли на оси точка, покрытая number_of_covered_points
+ * кругами радиуса radius» для всех шагов бинпоиска. Точки хранятся по
+ * столбцам (x и y^2), полуширины хорд считаются векторно, границы
+ * пишутся без ветвлений в переиспользуемый буфер упакованных ключей
+ * и сортируются поразрядно (SortKeys).
+ */
+class SweepLine {
+ public:
+  explicit SweepLine(const std::vector<Point>& points):
+      points_count_(points.size()) {
+    size_t padded_count = (points_count_ + DOUBLE_VECTOR_SIZE - 1) /
+        DOUBLE_VECTOR_SIZE * DOUBLE_VECTOR_SIZE;
+    x_coordinates_.resize(padded_count, 0.0);
+    squared_y_coordinates_.resize(padded_count, 0.0);
+    for (size_t i = 0; i < points_count_; ++i) {
+      x_coordinates_[i] = points[i].x_coordinate;
+      squared_y_coordinates_[i] = points[i].y_coordinate * points[i].y_coordinate;
+    }
+    half_chords_.resize(padded_count);
+    keys_.resize(2 * points_count_ + 2);
+    buffer_.resize(keys_.size());
+  }
+
+  bool Covers(double radius, int number_of_covered_points) {
+    DoubleVector squared_radius = {};
+    squared_radius += radius * radius;
+    for (size_t i = 0; i < half_chords_.size(); i += DOUBLE_VECTOR_SIZE) {
+      store_vector(&half_chords_[i],
+                   vector_sqrt(squared_radius - load_vector(&squared_y_coordinates_[i])));
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < points_count_; ++i) {
+      double half_chord = half_chords_[i];
+      keys_[count] = encode_border_point(x_coordinates_[i] - half_chord, 0);
+      keys_[count + 1] = encode_border_point(x_coordinates_[i] + half_chord, 1);
+      count += 2 * (half_chord >= 0);
+    }
+    if (number_of_covered_points > static_cast<int64_t>(count / 2)) {
+      return false;
+    }
+    SortKeys(count);
+    int intersection_counter = 0;
+    for (size_t i = 0; i < count; ++i) {
+      intersection_counter += 1 - 2 * static_cast<int>(keys_[i] & 1);
+      if (intersection_counter >= number_of_covered_points) {
+        return true;
       }
-      if (segment.end != MAX_BORDER) {
-        border_points.emplace_back(BorderPoint(segment.end, "right"));
+    }
+    return false;
+  }
+
+ private:
+  size_t points_count_;
+  std::vector<double> x_coordinates_;
+  std::vector<double> squared_y_coordinates_;
+  std::vector<double> half_chords_;
+  std::vector<uint64_t> keys_;
+  std::vector<uint64_t> buffer_;
+  size_t histograms_[RADIX_PASSES][RADIX_BUCKETS];
+
+  /*
+   * LSD-сортировка по байтам; гистограммы всех разрядов считаются за
+   * один проход, а разряды, в которых у всех ключей одна цифра
+   * (например, знак и порядок при близких координатах), пропускаются.
+   */
+  void SortKeys(size_t count) {
+    std::memset(histograms_, 0, sizeof(histograms_));
+    for (size_t i = 0; i < count; ++i) {
+      for (int pass = 0; pass < RADIX_PASSES; ++pass) {
+        ++histograms_[pass][(keys_[i] >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
       }
     }
-    std::sort(border_points.begin(), border_points.end(), BorderPointComparator());
-    int intersection_counter = 0;
-    bool find_success = false;
-    for (auto &border_point: border_points) {
-      if (border_point.type == "left") {
-        intersection_counter += 1;
+    for (int pass = 0; pass < RADIX_PASSES; ++pass) {
+      auto &histogram = histograms_[pass];
+      int shift = pass * RADIX_BITS;
+      if (count == 0 || histogram[(keys_[0] >> shift) & (RADIX_BUCKETS - 1)] == count) {
+        continue;
       }
-      if (border_point.type == "right") {
-        intersection_counter -= 1;
+      size_t offset = 0;
+      for (auto &bucket: histogram) {
+        size_t bucket_size = bucket;
+        bucket = offset;
+        offset += bucket_size;
       }
-      if (intersection_counter >= number_of_covered_points) {
-        approved_radius = current_radius;
-        find_success = true;
-        break;
+      for (size_t i = 0; i < count; ++i) {
+        buffer_[histogram[(keys_[i] >> shift) & (RADIX_BUCKETS - 1)]++] = keys_[i];
       }
+      keys_.swap(buffer_);
     }
-    if (!find_success) {
+  }
+};
+
+double find_minimal_covering_radius(const std::vector<Point>& points,
+                                    int number_of_covered_points) {
+  SweepLine sweep_line(points);
+  double insufficient_radius = 0;
+  double approved_radius = MAX_RADIUS;
+  while (approved_radius - insufficient_radius >= PRECISION) {
+    auto current_radius = (approved_radius - insufficient_radius) / 2 + insufficient_radius;
+    if (sweep_line.Covers(current_radius, number_of_covered_points)) {
+      approved_radius = current_radius;
+    } else {
       insufficient_radius = current_radius;
     }
   }
@@ -102,17 +186,15 @@ double find_minimal_covering_radius(const std::vector<Point>& points,
 }
 
 int main() {
-  std::ios_base::sync_with_stdio(false);
+  FastReader reader;
+  FastWriter writer;
 
-  int number_of_points;
-  int number_of_covered_points;
-  std::cin >> number_of_points;
-  std::cin >> number_of_covered_points;
-  auto points = read_points(number_of_points);
+  int number_of_points = reader.ReadInteger();
+  int number_of_covered_points = reader.ReadInteger();
+  auto points = read_points(number_of_points, reader);
 
   auto minimal_covering_radius = find_minimal_covering_radius(points, number_of_covered_points);
 
-  std::cout.precision(7);
-  std::cout << minimal_covering_radius << std::endl;
+  writer.WriteFormatted("%.7g\n", minimal_covering_radius);
   return 0;
 }
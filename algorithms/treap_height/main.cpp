@@ -1,49 +1,626 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <iomanip>
 
-constexpr size_t MAX_N_ELEMENTS = 101;
+#include "../common/fast_io.h"
 
-std::vector<size_t> read_input() {
-  size_t n_elements, height;
-  std::cin >> n_elements >> height;
-  return std::vector<size_t>({n_elements, height});
+constexpr size_t TABLE_HEIGHTS_COUNT = 96;
+constexpr char TABLE_MAGIC[8] = "TREAPHT";
+constexpr uint32_t TABLE_VERSION = 2;
+constexpr size_t PRECISION_NAME_SIZE = 16;
+constexpr size_t PARALLEL_CHUNK_SIZE = 64;
+constexpr double DEKKER_SPLITTER = 134217729.0;
+
+std::vector<std::pair<size_t, size_t>> read_input(FastReader& reader) {
+  std::vector<std::pair<size_t, size_t>> queries;
+  while (reader.SkipSpaces()) {
+    size_t n_elements = reader.ReadInteger<size_t>();
+    size_t height = reader.ReadInteger<size_t>();
+    queries.emplace_back(n_elements, height);
+  }
+  return queries;
 }
 
-long double get_answer(size_t n_elements, size_t height) {
-  if (height >= n_elements) {
-    return 0.0;
+template <class Function>
+void parallel_for(size_t count, size_t threads_count, Function function) {
+  std::atomic<size_t> next_chunk(0);
+  auto worker = [&]() {
+    for (size_t begin = next_chunk.fetch_add(PARALLEL_CHUNK_SIZE); begin < count;
+         begin = next_chunk.fetch_add(PARALLEL_CHUNK_SIZE)) {
+      function(begin, std::min(count, begin + PARALLEL_CHUNK_SIZE));
+    }
+  };
+  size_t chunks_count = (count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+  threads_count = std::max<size_t>(1, std::min(threads_count, chunks_count));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < threads_count; ++i) {
+    threads.emplace_back(worker);
   }
-  std::vector<std::vector<long double>> prob(MAX_N_ELEMENTS,
-                                             std::vector<long double>(MAX_N_ELEMENTS, 0.0));
-  for (size_t i = 0 ; i < n_elements + 1; ++i) {
-    if (i != 0) {
-      prob[i][0] = 0.0;
-    } else {
-      prob[i][0] = 1.0;
+  worker();
+  for (auto &thread: threads) {
+    thread.join();
+  }
+}
+
+/*
+ * Свёртки столбца таблицы с самим собой в разной точности. У каждой
+ * свёртки есть предыдущий столбец (previous) и его копия в обратном
+ * порядке (reversed): previous[n - 1 - k] = reversed[max_elements - n + 1 + k],
+ * поэтому оба множителя суммы читаются подряд с единичным шагом.
+ * Compute(n, begin) считает новое значение для n, складывая произведения
+ * с k от begin до середины, и может вызываться для разных n из разных
+ * потоков; Advance делает посчитанный столбец предыдущим.
+ *
+ * LongDoubleConvolution — исходная точность, эталон. DoubleConvolution
+ * считает в double по DOUBLE_VECTOR_SIZE произведений за раз векторными
+ * расширениями GCC. DoubleDoubleConvolution хранит числа парами double
+ * (старшая и младшая части) и складывает произведения без потери
+ * младших разрядов: произведение раскладывается точно по Деккеру
+ * (старшие части столбца разложены заранее, в Advance), сумма — по
+ * Кнуту (two-sum), тоже векторно.
+ */
+
+using DoubleVector = double __attribute__((vector_size(16)));
+constexpr size_t DOUBLE_VECTOR_SIZE = sizeof(DoubleVector) / sizeof(double);
+
+template <class Real>
+Real two_sum(Real first, Real second, Real& error) {
+  Real sum = first + second;
+  Real second_part = sum - first;
+  error = (first - (sum - second_part)) + (second - second_part);
+  return sum;
+}
+
+template <class Real>
+void dekker_split(Real value, Real& high, Real& low) {
+  Real scaled = value * DEKKER_SPLITTER;
+  high = scaled - (scaled - value);
+  low = value - high;
+}
+
+template <class Real>
+Real two_product(Real first, Real second, Real& error) {
+  Real product = first * second;
+  Real first_high, first_low, second_high, second_low;
+  dekker_split(first, first_high, first_low);
+  dekker_split(second, second_high, second_low);
+  error = ((first_high * second_high - product) + first_high * second_low +
+           first_low * second_high) + first_low * second_low;
+  return product;
+}
+
+DoubleVector load_vector(const double* values) {
+  DoubleVector vector;
+  std::memcpy(&vector, values, sizeof(vector));
+  return vector;
+}
+
+class LongDoubleConvolution {
+ public:
+  static constexpr const char* NAME = "long-double";
+
+  explicit LongDoubleConvolution(size_t max_elements):
+      max_elements_(max_elements),
+      previous_(max_elements + 1, 0.0),
+      current_(max_elements + 1, 0.0) {
+    for (size_t n = 0; n <= std::min<size_t>(1, max_elements); ++n) {
+      previous_[n] = 1.0;
+    }
+  }
+
+  bool IsZero(size_t n) const {
+    return previous_[n] == 0.0;
+  }
+
+  bool IsOne(size_t n) const {
+    return previous_[n] == 1.0;
+  }
+
+  long double Previous(size_t n) const {
+    return previous_[n];
+  }
+
+  void Set(size_t n, long double value) {
+    current_[n] = value;
+  }
+
+  void Compute(size_t n, size_t begin) {
+    long double sum = 0.0;
+    for (size_t k = begin; 2 * k + 1 < n; ++k) {
+      sum += previous_[k] * previous_[n - 1 - k];
+    }
+    sum *= 2;
+    if (n % 2 == 1) {
+      sum += previous_[n / 2] * previous_[n / 2];
+    }
+    current_[n] = std::min<long double>(sum / n, 1.0);
+  }
+
+  void Advance() {
+    std::swap(previous_, current_);
+  }
+
+ private:
+  size_t max_elements_;
+  std::vector<long double> previous_;
+  std::vector<long double> current_;
+};
+
+class DoubleConvolution {
+ public:
+  static constexpr const char* NAME = "double";
+
+  explicit DoubleConvolution(size_t max_elements):
+      max_elements_(max_elements),
+      previous_(max_elements + 1, 0.0),
+      reversed_(max_elements + 1, 0.0),
+      current_(max_elements + 1, 0.0) {
+    for (size_t n = 0; n <= std::min<size_t>(1, max_elements); ++n) {
+      current_[n] = 1.0;
+    }
+    Advance();
+  }
+
+  bool IsZero(size_t n) const {
+    return previous_[n] == 0.0;
+  }
+
+  bool IsOne(size_t n) const {
+    return previous_[n] == 1.0;
+  }
+
+  long double Previous(size_t n) const {
+    return previous_[n];
+  }
+
+  void Set(size_t n, long double value) {
+    current_[n] = value;
+  }
+
+  void Compute(size_t n, size_t begin) {
+    const double* first = previous_.data();
+    const double* second = reversed_.data() + max_elements_ - n + 1;
+    size_t end = n / 2;
+    DoubleVector sums = {};
+    DoubleVector other_sums = {};
+    size_t k = begin;
+    for (; k + 2 * DOUBLE_VECTOR_SIZE <= end; k += 2 * DOUBLE_VECTOR_SIZE) {
+      sums += load_vector(first + k) * load_vector(second + k);
+      other_sums += load_vector(first + k + DOUBLE_VECTOR_SIZE) *
+          load_vector(second + k + DOUBLE_VECTOR_SIZE);
+    }
+    sums += other_sums;
+    double sum = 0.0;
+    for (size_t lane = 0; lane < DOUBLE_VECTOR_SIZE; ++lane) {
+      sum += sums[lane];
+    }
+    for (; k < end; ++k) {
+      sum += first[k] * second[k];
+    }
+    sum *= 2;
+    if (n % 2 == 1) {
+      sum += previous_[n / 2] * previous_[n / 2];
+    }
+    current_[n] = std::min(sum / n, 1.0);
+  }
+
+  void Advance() {
+    std::swap(previous_, current_);
+    std::reverse_copy(previous_.begin(), previous_.end(), reversed_.begin());
+  }
+
+ private:
+  size_t max_elements_;
+  std::vector<double> previous_;
+  std::vector<double> reversed_;
+  std::vector<double> current_;
+};
+
+class DoubleDoubleConvolution {
+ public:
+  static constexpr const char* NAME = "double-double";
+
+  explicit DoubleDoubleConvolution(size_t max_elements):
+      max_elements_(max_elements),
+      previous_(max_elements + 1),
+      reversed_(max_elements + 1),
+      current_high_(max_elements + 1, 0.0),
+      current_low_(max_elements + 1, 0.0) {
+    for (size_t n = 0; n <= std::min<size_t>(1, max_elements); ++n) {
+      current_high_[n] = 1.0;
+    }
+    Advance();
+  }
+
+  bool IsZero(size_t n) const {
+    return previous_.high[n] == 0.0;
+  }
+
+  bool IsOne(size_t n) const {
+    return previous_.high[n] == 1.0 && previous_.low[n] == 0.0;
+  }
+
+  long double Previous(size_t n) const {
+    return static_cast<long double>(previous_.high[n]) + previous_.low[n];
+  }
+
+  void Set(size_t n, long double value) {
+    current_high_[n] = static_cast<double>(value);
+    current_low_[n] = static_cast<double>(value - current_high_[n]);
+  }
+
+  void Compute(size_t n, size_t begin) {
+    size_t offset = max_elements_ - n + 1;
+    size_t end = n / 2;
+    DoubleVector sums_high = {};
+    DoubleVector sums_low = {};
+    size_t k = begin;
+    for (; k + DOUBLE_VECTOR_SIZE <= end; k += DOUBLE_VECTOR_SIZE) {
+      AccumulateProduct(previous_.Load(k), reversed_.Load(offset + k), sums_high, sums_low);
+    }
+    double sum_high = 0.0;
+    double sum_low = 0.0;
+    for (size_t lane = 0; lane < DOUBLE_VECTOR_SIZE; ++lane) {
+      double error;
+      sum_high = two_sum(sum_high, sums_high[lane], error);
+      sum_low += error + sums_low[lane];
+    }
+    for (; k < end; ++k) {
+      AccumulateProduct(previous_.Get(k), reversed_.Get(offset + k), sum_high, sum_low);
     }
+    sum_high *= 2;
+    sum_low *= 2;
+    if (n % 2 == 1) {
+      AccumulateProduct(previous_.Get(n / 2), previous_.Get(n / 2), sum_high, sum_low);
+    }
+    double error;
+    sum_high = two_sum(sum_high, sum_low, error);
+    sum_low = error;
+    double quotient = sum_high / n;
+    double remainder_high = two_product(quotient, static_cast<double>(n), error);
+    double correction = ((sum_high - remainder_high) - error + sum_low) / n;
+    current_high_[n] = two_sum(quotient, correction, current_low_[n]);
+    if (current_high_[n] >= 1.0) {
+      current_high_[n] = 1.0;
+      current_low_[n] = 0.0;
+    }
+  }
+
+  void Advance() {
+    for (size_t n = 0; n <= max_elements_; ++n) {
+      previous_.Store(n, current_high_[n], current_low_[n]);
+      reversed_.Store(max_elements_ - n, current_high_[n], current_low_[n]);
+    }
+  }
+
+ private:
+  /*
+   * Число (high, low) вместе с заранее посчитанным разложением high по
+   * Деккеру, чтобы не раскладывать множители заново в каждом произведении.
+   */
+  template <class Real>
+  struct SplitNumber {
+    Real high;
+    Real low;
+    Real high_upper;
+    Real high_lower;
+  };
+
+  struct SplitColumn {
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<double> high_upper;
+    std::vector<double> high_lower;
+
+    explicit SplitColumn(size_t size):
+        high(size, 0.0), low(size, 0.0), high_upper(size, 0.0), high_lower(size, 0.0)
+    {}
+
+    void Store(size_t index, double high_part, double low_part) {
+      high[index] = high_part;
+      low[index] = low_part;
+      dekker_split(high_part, high_upper[index], high_lower[index]);
+    }
+
+    SplitNumber<double> Get(size_t index) const {
+      return {high[index], low[index], high_upper[index], high_lower[index]};
+    }
+
+    SplitNumber<DoubleVector> Load(size_t index) const {
+      return {load_vector(&high[index]), load_vector(&low[index]),
+              load_vector(&high_upper[index]), load_vector(&high_lower[index])};
+    }
+  };
+
+  size_t max_elements_;
+  SplitColumn previous_;
+  SplitColumn reversed_;
+  std::vector<double> current_high_;
+  std::vector<double> current_low_;
+
+  /*
+   * sum += first * second; произведение младших частей меньше точности
+   * результата и отбрасывается.
+   */
+  template <class Real>
+  static void AccumulateProduct(const SplitNumber<Real>& first, const SplitNumber<Real>& second,
+                                Real& sum_high, Real& sum_low) {
+    Real product = first.high * second.high;
+    Real product_error = ((first.high_upper * second.high_upper - product) +
+                          first.high_upper * second.high_lower +
+                          first.high_lower * second.high_upper) +
+                         first.high_lower * second.high_lower;
+    product_error += first.high * second.low + first.low * second.high;
+    Real sum_error;
+    sum_high = two_sum(sum_high, product, sum_error);
+    sum_low += sum_error + product_error;
+  }
+};
+
+/*
+ * Таблица cumulative[h][n] = P(высота декартова дерева из n элементов
+ * не больше h), посчитанная один раз для всех n <= max_elements и
+ * h < TABLE_HEIGHTS_COUNT. Дерево высоты не больше h — это корень и два
+ * поддерева высоты не больше h - 1, а корнем с равной вероятностью
+ * становится любой из n элементов, поэтому
+ *   cumulative[h][n] = (1 / n) * sum_k cumulative[h - 1][k] * cumulative[h - 1][n - 1 - k],
+ * то есть столбец высоты h — свёртка предыдущего столбца с самим собой,
+ * и столбцы хранятся подряд. Сумма симметрична по k, поэтому считается
+ * её половина; нулевые хвосты столбца и уже равные единице значения
+ * пропускаются, а значения разных n одного столбца независимы и
+ * считаются параллельно. Вероятность высоты ровно h — разность соседних
+ * столбцов, так что запрос отвечается за O(1).
+ *
+ * Даже при n = 10^4 вероятность высоты больше 64 меньше 10^-18, поэтому
+ * высоты от TABLE_HEIGHTS_COUNT и выше считаются имеющими нулевую
+ * вероятность. Таблицу можно сохранить на диск и загрузить обратно.
+ */
+
+class TreapHeightTable {
+ public:
+  template <class Convolution = LongDoubleConvolution>
+  static TreapHeightTable Build(size_t max_elements, size_t threads_count = 1) {
+    static_assert(std::char_traits<char>::length(Convolution::NAME) < PRECISION_NAME_SIZE,
+                  "Precision name must fit into the table header");
+    TreapHeightTable table;
+    table.max_elements_ = max_elements;
+    table.precision_ = Convolution::NAME;
+    table.cumulative_.resize(TABLE_HEIGHTS_COUNT * (max_elements + 1));
+    table.Fill<Convolution>(threads_count);
+    return table;
+  }
+
+  explicit TreapHeightTable(const std::string& path) {
+    Load(path);
+  }
+
+  size_t max_elements() const {
+    return max_elements_;
+  }
+
+  const std::string& precision() const {
+    return precision_;
+  }
+
+  long double GetProbability(size_t n_elements, size_t height) const {
+    if (height >= n_elements || height >= TABLE_HEIGHTS_COUNT) {
+      return 0.0;
+    }
+    if (height == 0) {
+      return Cumulative(0, n_elements);
+    }
+    return Cumulative(height, n_elements) - Cumulative(height - 1, n_elements);
   }
-  prob[1][0] = 1.0;
-  prob[1][1] = 0.0;
-  for (size_t num = 2; num <= n_elements; ++num) {
-    for (size_t h = 1; h <= height; ++h) {
-      long double temp_prob = 0.0;
-      for (size_t k = 0; k <= num - 1; ++k) {
-        for (size_t m = 0; m < h - 1; ++m) {
-          temp_prob += 2.0 * prob[k][h - 1] * prob[num - k - 1][m];
+
+  void Save(const std::string& path) const {
+    TableHeader header = MakeHeader();
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(cumulative_.data()),
+                 cumulative_.size() * sizeof(long double));
+    if (!stream) {
+      throw std::runtime_error("Cannot write table to " + path);
+    }
+  }
+
+ private:
+  struct TableHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t value_size;
+    uint64_t heights_count;
+    uint64_t max_elements;
+    char precision[PRECISION_NAME_SIZE];
+  };
+
+  size_t max_elements_;
+  std::string precision_;
+  std::vector<long double> cumulative_;
+
+  TreapHeightTable(): max_elements_(0)
+  {}
+
+  long double Cumulative(size_t height, size_t n_elements) const {
+    return cumulative_[height * (max_elements_ + 1) + n_elements];
+  }
+
+  TableHeader MakeHeader() const {
+    TableHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_VERSION;
+    header.value_size = sizeof(long double);
+    header.heights_count = TABLE_HEIGHTS_COUNT;
+    header.max_elements = max_elements_;
+    precision_.copy(header.precision, sizeof(header.precision) - 1);
+    return header;
+  }
+
+  template <class Convolution>
+  void Fill(size_t threads_count) {
+    size_t row_size = max_elements_ + 1;
+    Convolution convolution(max_elements_);
+    for (size_t n = 0; n <= max_elements_; ++n) {
+      cumulative_[n] = convolution.Previous(n);
+    }
+    for (size_t height = 1; height < TABLE_HEIGHTS_COUNT; ++height) {
+      size_t nonzero_end = 0;
+      while (nonzero_end <= max_elements_ && !convolution.IsZero(nonzero_end)) {
+        ++nonzero_end;
+      }
+      parallel_for(row_size, threads_count, [&](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) {
+          if (n <= 1 || convolution.IsOne(n)) {
+            convolution.Set(n, 1.0);
+          } else if (n > 2 * nonzero_end) {
+            convolution.Set(n, 0.0);
+          } else {
+            convolution.Compute(n, n > nonzero_end ? n - nonzero_end : 0);
+          }
         }
+      });
+      convolution.Advance();
+      long double* column = cumulative_.data() + height * row_size;
+      for (size_t n = 0; n <= max_elements_; ++n) {
+        column[n] = convolution.Previous(n);
       }
-      for (size_t k = 0; k <= num - 1; ++k) {
-        temp_prob += prob[k][h - 1] * prob[num - k - 1][h - 1];
+    }
+  }
+
+  void Load(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary);
+    TableHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+      throw std::runtime_error("Cannot read table from " + path);
+    }
+    max_elements_ = header.max_elements;
+    precision_.assign(header.precision, strnlen(header.precision, sizeof(header.precision)));
+    TableHeader expected = MakeHeader();
+    if (std::memcmp(&header, &expected, sizeof(header)) != 0) {
+      throw std::runtime_error(path + " is not a compatible treap height table");
+    }
+    cumulative_.resize(TABLE_HEIGHTS_COUNT * (max_elements_ + 1));
+    if (!stream.read(reinterpret_cast<char*>(cumulative_.data()),
+                     cumulative_.size() * sizeof(long double))) {
+      throw std::runtime_error("Table " + path + " is truncated");
+    }
+  }
+};
+
+struct program_options {
+  std::string cache_path;
+  std::string precision = LongDoubleConvolution::NAME;
+  size_t threads_count = 1;
+  bool benchmark = false;
+};
+
+program_options parse_program_options(int argc, char* argv[]) {
+  program_options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string option = argv[i];
+    if (option == "--bench") {
+      options.benchmark = true;
+    } else if (option == "--cache" && i + 1 < argc) {
+      options.cache_path = argv[++i];
+    } else if (option == "--precision" && i + 1 < argc) {
+      options.precision = argv[++i];
+    } else if (option == "--threads" && i + 1 < argc) {
+      options.threads_count = std::max(1ul, std::stoul(argv[++i]));
+    } else {
+      throw std::invalid_argument("Unknown option " + option);
+    }
+  }
+  return options;
+}
+
+TreapHeightTable build_table(size_t max_elements, const std::string& precision,
+                             size_t threads_count) {
+  if (precision == LongDoubleConvolution::NAME) {
+    return TreapHeightTable::Build<LongDoubleConvolution>(max_elements, threads_count);
+  } else if (precision == DoubleConvolution::NAME) {
+    return TreapHeightTable::Build<DoubleConvolution>(max_elements, threads_count);
+  } else if (precision == DoubleDoubleConvolution::NAME) {
+    return TreapHeightTable::Build<DoubleDoubleConvolution>(max_elements, threads_count);
+  }
+  throw std::invalid_argument("Unknown precision " + precision);
+}
+
+/*
+ * Таблица из кеша options.cache_path, если он есть, покрывает
+ * max_elements и посчитан в точности options.precision; иначе таблица
+ * строится заново и, если путь задан, записывается в кеш.
+ */
+
+TreapHeightTable get_table(size_t max_elements, const program_options& options) {
+  if (!options.cache_path.empty() && std::ifstream(options.cache_path).good()) {
+    TreapHeightTable table(options.cache_path);
+    if (table.max_elements() >= max_elements && table.precision() == options.precision) {
+      return table;
+    }
+  }
+  auto table = build_table(max_elements, options.precision, options.threads_count);
+  if (!options.cache_path.empty()) {
+    table.Save(options.cache_path);
+  }
+  return table;
+}
+
+/*
+ * Точность и скорость построения таблицы в каждой точности на одном и
+ * нескольких потоках; ошибка — наибольшее отклонение вероятности высоты
+ * от посчитанной в long double.
+ */
+
+void write_benchmark(FastWriter& writer) {
+  size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+  for (size_t max_elements: {2000, 10000}) {
+    auto reference = TreapHeightTable::Build<LongDoubleConvolution>(max_elements);
+    for (const auto* precision: {LongDoubleConvolution::NAME, DoubleConvolution::NAME,
+                                 DoubleDoubleConvolution::NAME}) {
+      for (size_t threads_count: {size_t(1), max_threads}) {
+        auto start = std::chrono::steady_clock::now();
+        auto table = build_table(max_elements, precision, threads_count);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        long double max_error = 0.0;
+        for (size_t n = 0; n <= max_elements; ++n) {
+          for (size_t height = 0; height < TABLE_HEIGHTS_COUNT; ++height) {
+            max_error = std::max(max_error, std::fabs(table.GetProbability(n, height) -
+                                                      reference.GetProbability(n, height)));
+          }
+        }
+        writer.WriteFormatted("n<=%zu %s, %zu threads: %.3f s, max error %.2Le\n", max_elements,
+                              precision, threads_count, elapsed.count(), max_error);
       }
-      prob[num][h] = temp_prob / num;
     }
   }
-  return prob[n_elements][height];
 }
 
-int main() {
-  auto input = read_input();
-  auto answer = get_answer(input[0], input[1]);
-  printf("%.10Lf\n", answer);
+int main(int argc, char* argv[]) {
+  auto options = parse_program_options(argc, argv);
+  FastWriter writer;
+  if (options.benchmark) {
+    write_benchmark(writer);
+    return 0;
+  }
+  FastReader reader;
+  auto queries = read_input(reader);
+  size_t max_elements = 1;
+  for (const auto &query: queries) {
+    max_elements = std::max(max_elements, query.first);
+  }
+  auto table = get_table(max_elements, options);
+  for (const auto &query: queries) {
+    writer.WriteFormatted("%.10Lf\n", table.GetProbability(query.first, query.second));
+  }
 }
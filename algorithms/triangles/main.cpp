@@ -1,9 +1,41 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
 
-constexpr int TABLESIZE = 5000000;
-constexpr long long PRIME = 1000001449;
+#include "../common/fast_io.h"
+
+constexpr uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+constexpr size_t MIN_TABLE_CAPACITY = 16;
+constexpr size_t NORMALIZE_BATCH_SIZE = 64;
+constexpr size_t BENCHMARK_TRIANGLES_COUNT = 10000000;
+constexpr size_t SHARDS_PER_THREAD = 4;
+constexpr int MIN_HYPER_LOG_LOG_PRECISION = 4;
+constexpr int MAX_HYPER_LOG_LOG_PRECISION = 18;
+constexpr size_t SPILL_BUFFER_TRIANGLES = 4096;
+constexpr size_t MAX_SPILL_RUNS = 64;
+constexpr size_t DEFAULT_MEMORY_BUDGET_MB = 1024;
+
+typedef int IntVector __attribute__((vector_size(16)));
+typedef int HalfIntVector __attribute__((vector_size(8)));
+typedef double DoubleVector __attribute__((vector_size(16)));
+typedef uint64_t HashVector __attribute__((vector_size(16)));
+
+constexpr size_t INT_VECTOR_SIZE = sizeof(IntVector) / sizeof(int);
+constexpr size_t DOUBLE_VECTOR_SIZE = sizeof(DoubleVector) / sizeof(double);
+constexpr size_t HASH_VECTOR_SIZE = sizeof(HashVector) / sizeof(uint64_t);
 
 struct Triangle {
   int a_segment;
@@ -17,9 +49,13 @@ struct Triangle {
     return first.a_segment == second.a_segment && first.b_segment == second.b_segment
         && first.c_segment == second.c_segment;
   }
+  friend bool operator<(const Triangle &first, const Triangle &second) {
+    return std::tie(first.a_segment, first.b_segment, first.c_segment)
+        < std::tie(second.a_segment, second.b_segment, second.c_segment);
+  }
 };
 
-int gcd(int first_number, int second_number) {
+int EuclideanGcd(int first_number, int second_number) {
   while (second_number) {
     first_number %= second_number;
     std::swap(first_number, second_number);
@@ -27,66 +63,862 @@ int gcd(int first_number, int second_number) {
   return first_number;
 }
 
-int hash(const Triangle& triangle) {
-  auto temp_calc = (triangle.a_segment * PRIME) % TABLESIZE;
-  temp_calc *= PRIME;
-  temp_calc %= TABLESIZE;
-  temp_calc += (triangle.b_segment * PRIME);
-  temp_calc %= TABLESIZE;
-  temp_calc += triangle.c_segment;
-  return temp_calc % TABLESIZE;
+/*
+ * Бинарный алгоритм Стейна: вместо деления — сдвиги на число младших
+ * нулей и вычитания. Число нулей разности считается одновременно
+ * с min и модулем, так что цепочка зависимостей на шаге короткая,
+ * а ветвление остаётся одно — выход из цикла.
+ */
+int gcd(int first_number, int second_number) {
+  if (first_number == 0 || second_number == 0) {
+    return first_number | second_number;
+  }
+  int first_zeros = __builtin_ctz(first_number);
+  int second_zeros = __builtin_ctz(second_number);
+  int shift = std::min(first_zeros, second_zeros);
+  first_number >>= first_zeros;
+  second_number >>= second_zeros;
+  while (first_number != 0) {
+    int difference = second_number - first_number;
+    first_zeros = __builtin_ctz(difference | (1 << 30));
+    second_number = std::min(first_number, second_number);
+    first_number = std::abs(difference) >> first_zeros;
+  }
+  return second_number << shift;
 }
 
-Triangle NormalizeTriangle(const Triangle& triangle) {
+/*
+ * Тот же алгоритм для INT_VECTOR_SIZE пар сразу: дорожки независимы,
+ * поэтому их шаги перекрываются в конвейере, а закончившая дорожка
+ * до выхода из цикла стоит на месте благодаря выбору без ветвлений.
+ */
+IntVector gcd(IntVector first_numbers, IntVector second_numbers) {
+  int first[INT_VECTOR_SIZE], second[INT_VECTOR_SIZE], shift[INT_VECTOR_SIZE];
+  bool running = false;
+  for (size_t lane = 0; lane < INT_VECTOR_SIZE; ++lane) {
+    first[lane] = first_numbers[lane];
+    second[lane] = second_numbers[lane];
+    shift[lane] = 0;
+    if (first[lane] == 0 || second[lane] == 0) {
+      second[lane] |= first[lane];
+      first[lane] = 0;
+      continue;
+    }
+    int first_zeros = __builtin_ctz(first[lane]);
+    int second_zeros = __builtin_ctz(second[lane]);
+    shift[lane] = std::min(first_zeros, second_zeros);
+    first[lane] >>= first_zeros;
+    second[lane] >>= second_zeros;
+    running = true;
+  }
+  while (running) {
+    running = false;
+    for (size_t lane = 0; lane < INT_VECTOR_SIZE; ++lane) {
+      int difference = second[lane] - first[lane];
+      int zeros = __builtin_ctz(difference | (1 << 30));
+      int smaller = std::min(first[lane], second[lane]);
+      second[lane] = first[lane] != 0 ? smaller : second[lane];
+      first[lane] = std::abs(difference) >> zeros & -(first[lane] != 0);
+      running |= first[lane] != 0;
+    }
+  }
+  IntVector result;
+  for (size_t lane = 0; lane < INT_VECTOR_SIZE; ++lane) {
+    result[lane] = second[lane] << shift[lane];
+  }
+  return result;
+}
+
+/*
+ * Хеш работает одинаково над одним числом и над вектором хешей,
+ * поэтому пакетная нормализация считает его сразу для нескольких
+ * треугольников.
+ */
+template <class Hash>
+Hash MixTriangleHash(Hash a_segment, Hash b_segment, Hash c_segment) {
+  Hash hash_value = a_segment;
+  hash_value = hash_value * HASH_MULTIPLIER + b_segment;
+  hash_value = hash_value * HASH_MULTIPLIER + c_segment;
+  hash_value ^= hash_value >> 32;
+  hash_value *= HASH_MULTIPLIER;
+  return hash_value ^ (hash_value >> 29);
+}
+
+uint64_t HashTriangle(const Triangle& triangle) {
+  return MixTriangleHash<uint64_t>(static_cast<uint32_t>(triangle.a_segment),
+                                   static_cast<uint32_t>(triangle.b_segment),
+                                   static_cast<uint32_t>(triangle.c_segment));
+}
+
+/*
+ * Множество нормализованных треугольников с открытой адресацией
+ * по схеме Robin Hood: при вставке элемент, ушедший от своей ячейки
+ * дальше, вытесняет более «близкий», поэтому длина пробега почти
+ * не зависит от заполненности, а поиск останавливается на первой
+ * ячейке, элемент которой ближе к дому, чем искомый. Треугольник
+ * и его смещение лежат в одной 16-байтной ячейке. Ёмкость выбирается
+ * по ожидаемому числу элементов, число классов — размер множества.
+ */
+
+class TriangleHashSet {
+ public:
+  explicit TriangleHashSet(size_t expected_size):
+      size_(0) {
+    size_t capacity = MIN_TABLE_CAPACITY;
+    while (capacity * MAX_LOAD_NUMERATOR < expected_size * MAX_LOAD_DENOMINATOR) {
+      capacity *= 2;
+    }
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+  }
+
+  bool Insert(const Triangle& triangle) {
+    return Insert(triangle, HashTriangle(triangle));
+  }
+
+  bool Insert(const Triangle& triangle, uint64_t hash_value) {
+    if ((size_ + 1) * MAX_LOAD_DENOMINATOR > slots_.size() * MAX_LOAD_NUMERATOR) {
+      Grow();
+    }
+    Slot current(triangle, 1);
+    size_t index = hash_value & mask_;
+    bool displacing = false;
+    while (true) {
+      auto &slot = slots_[index];
+      if (slot.distance == 0) {
+        slot = current;
+        ++size_;
+        return true;
+      }
+      if (slot.distance < current.distance) {
+        std::swap(slot, current);
+        displacing = true;
+      } else if (!displacing && slot.distance == current.distance
+                 && slot.triangle == current.triangle) {
+        return false;
+      }
+      ++current.distance;
+      index = (index + 1) & mask_;
+    }
+  }
+
+  /*
+   * Отдаёт элементы по возрастанию и опустошает множество. Сортировка
+   * идёт прямо в массиве ячеек, без дополнительной памяти.
+   */
+  template <class Function>
+  void DrainSorted(Function function) {
+    auto occupied_end = std::remove_if(slots_.begin(), slots_.end(), [](const Slot& slot) {
+      return slot.distance == 0;
+    });
+    std::sort(slots_.begin(), occupied_end, [](const Slot& first, const Slot& second) {
+      return first.triangle < second.triangle;
+    });
+    for (auto slot = slots_.begin(); slot != occupied_end; ++slot) {
+      function(slot->triangle);
+    }
+    std::fill(slots_.begin(), slots_.end(), Slot());
+    size_ = 0;
+  }
+
+  /*
+   * Наибольшее число элементов, при котором таблица, созданная под него,
+   * помещается в memory_budget байт и не растёт.
+   */
+  static size_t MaxSizeWithin(size_t memory_budget) {
+    size_t capacity = MIN_TABLE_CAPACITY;
+    while (capacity * 2 * sizeof(Slot) <= memory_budget) {
+      capacity *= 2;
+    }
+    return capacity * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR;
+  }
+
+  void Prefetch(uint64_t hash_value) const {
+    __builtin_prefetch(&slots_[hash_value & mask_]);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+  static constexpr size_t MAX_LOAD_DENOMINATOR = 8;
+
+  /*
+   * distance == 0 — пустая ячейка, иначе 1 + расстояние от ячейки,
+   * в которую элемент попал бы по хешу.
+   */
+  struct Slot {
+    Triangle triangle;
+    uint32_t distance;
+    Slot(const Triangle& triangle_, uint32_t distance_):
+        triangle(triangle_), distance(distance_)
+    {}
+    Slot(): distance(0) {}
+  };
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  size_t size_;
+
+  void Grow() {
+    std::vector<Slot> old_slots(slots_.size() * 2);
+    old_slots.swap(slots_);
+    mask_ = slots_.size() - 1;
+    size_ = 0;
+    for (const auto &slot: old_slots) {
+      if (slot.distance != 0) {
+        Insert(slot.triangle);
+      }
+    }
+  }
+};
+
+Triangle NormalizeTriangleWithSort(const Triangle& triangle) {
   std::vector<int> segments({triangle.a_segment, triangle.b_segment, triangle.c_segment});
   std::sort(segments.begin(), segments.end());
-  int factor = gcd(triangle.a_segment, gcd(triangle.b_segment, triangle.c_segment));
+  int factor = EuclideanGcd(triangle.a_segment,
+                            EuclideanGcd(triangle.b_segment, triangle.c_segment));
   Triangle normalized = Triangle(segments[0] / factor, segments[1] / factor, segments[2] / factor);
   return normalized;
 }
 
-std::vector<Triangle> ReadInput(int size) {
+void CompareExchange(int& first, int& second) {
+  int smaller = std::min(first, second);
+  second = std::max(first, second);
+  first = smaller;
+}
+
+void CompareExchange(IntVector& first, IntVector& second) {
+  IntVector smaller = first < second ? first : second;
+  second = first < second ? second : first;
+  first = smaller;
+}
+
+/*
+ * Сеть сортировки из трёх компараторов: без ветвлений и без памяти,
+ * одинаково для чисел и для векторов сторон.
+ */
+template <class Segment>
+void SortSegments(Segment& a_segment, Segment& b_segment, Segment& c_segment) {
+  CompareExchange(a_segment, b_segment);
+  CompareExchange(b_segment, c_segment);
+  CompareExchange(a_segment, b_segment);
+}
+
+Triangle NormalizeTriangle(const Triangle& triangle) {
+  int a_segment = triangle.a_segment;
+  int b_segment = triangle.b_segment;
+  int c_segment = triangle.c_segment;
+  SortSegments(a_segment, b_segment, c_segment);
+  int factor = gcd(a_segment, gcd(b_segment, c_segment));
+  return Triangle(a_segment / factor, b_segment / factor, c_segment / factor);
+}
+
+/*
+ * Делит стороны на их НОД в double по DOUBLE_VECTOR_SIZE дорожек за раз;
+ * деление точное, так как НОД делит каждую сторону.
+ */
+IntVector DivideExactly(IntVector segments, IntVector factors) {
+  for (size_t half = 0; half < INT_VECTOR_SIZE; half += DOUBLE_VECTOR_SIZE) {
+    HalfIntVector half_segments = {segments[half], segments[half + 1]};
+    HalfIntVector half_factors = {factors[half], factors[half + 1]};
+    HalfIntVector quotients = __builtin_convertvector(
+        __builtin_convertvector(half_segments, DoubleVector) /
+        __builtin_convertvector(half_factors, DoubleVector), HalfIntVector);
+    segments[half] = quotients[0];
+    segments[half + 1] = quotients[1];
+  }
+  return segments;
+}
+
+/*
+ * Нормализует и хеширует треугольники блоками по INT_VECTOR_SIZE:
+ * стороны блока сортируются векторными min/max, НОД считается
+ * по дорожкам, а деление на него — в double, по половине блока за раз.
+ * Хеши блока считаются одним вектором.
+ */
+void NormalizeTriangles(const Triangle* triangles, size_t count,
+                        Triangle* normalized, uint64_t* hashes) {
+  size_t index = 0;
+  for (; index + INT_VECTOR_SIZE <= count; index += INT_VECTOR_SIZE) {
+    IntVector a_segments, b_segments, c_segments;
+    for (size_t lane = 0; lane < INT_VECTOR_SIZE; ++lane) {
+      a_segments[lane] = triangles[index + lane].a_segment;
+      b_segments[lane] = triangles[index + lane].b_segment;
+      c_segments[lane] = triangles[index + lane].c_segment;
+    }
+    SortSegments(a_segments, b_segments, c_segments);
+    IntVector factors = gcd(a_segments, gcd(b_segments, c_segments));
+    a_segments = DivideExactly(a_segments, factors);
+    b_segments = DivideExactly(b_segments, factors);
+    c_segments = DivideExactly(c_segments, factors);
+    for (size_t lane = 0; lane < INT_VECTOR_SIZE; ++lane) {
+      normalized[index + lane] = Triangle(a_segments[lane], b_segments[lane], c_segments[lane]);
+    }
+    for (size_t half = 0; half < INT_VECTOR_SIZE; half += HASH_VECTOR_SIZE) {
+      HashVector a_hashes, b_hashes, c_hashes;
+      for (size_t lane = 0; lane < HASH_VECTOR_SIZE; ++lane) {
+        a_hashes[lane] = static_cast<uint32_t>(a_segments[half + lane]);
+        b_hashes[lane] = static_cast<uint32_t>(b_segments[half + lane]);
+        c_hashes[lane] = static_cast<uint32_t>(c_segments[half + lane]);
+      }
+      HashVector hash_values = MixTriangleHash(a_hashes, b_hashes, c_hashes);
+      for (size_t lane = 0; lane < HASH_VECTOR_SIZE; ++lane) {
+        hashes[index + half + lane] = hash_values[lane];
+      }
+    }
+  }
+  for (; index < count; ++index) {
+    normalized[index] = NormalizeTriangle(triangles[index]);
+    hashes[index] = HashTriangle(normalized[index]);
+  }
+}
+
+std::vector<Triangle> ReadInput(FastReader& reader, size_t size) {
   std::vector<Triangle> triangles;
-  for (int i = 0; i < size; ++i) {
-    int a_segment, b_segment, c_segment;
-    std::cin >> a_segment >> b_segment >> c_segment;
+  triangles.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    int a_segment = reader.ReadInteger();
+    int b_segment = reader.ReadInteger();
+    int c_segment = reader.ReadInteger();
     triangles.emplace_back(Triangle({a_segment, b_segment, c_segment}));
   }
   return triangles;
 }
 
-int GetSimilarityClasses(const std::vector<Triangle>& triangles) {
-  std::vector<std::vector<Triangle>> table;
-  table.reserve(TABLESIZE);
-  for (auto &triangle: triangles) {
-    auto normalized = NormalizeTriangle(triangle);
-    auto hash_value = hash(normalized);
-    if (table[hash_value].empty()) {
-      table[hash_value].push_back(normalized);
-    } else {
-      bool found = false;
-      for (auto &other: table[hash_value]) {
-        if (other == normalized) {
-          found = true;
-          break;
+/*
+ * Треугольники нормализуются пачками; перед вставкой пачки ячейки
+ * таблицы для всех её хешей заранее запрашиваются в кеш.
+ */
+size_t GetSimilarityClasses(const std::vector<Triangle>& triangles) {
+  TriangleHashSet classes(triangles.size());
+  Triangle normalized[NORMALIZE_BATCH_SIZE];
+  uint64_t hashes[NORMALIZE_BATCH_SIZE];
+  for (size_t begin = 0; begin < triangles.size(); begin += NORMALIZE_BATCH_SIZE) {
+    size_t count = std::min(NORMALIZE_BATCH_SIZE, triangles.size() - begin);
+    NormalizeTriangles(triangles.data() + begin, count, normalized, hashes);
+    for (size_t i = 0; i < count; ++i) {
+      classes.Prefetch(hashes[i]);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      classes.Insert(normalized[i], hashes[i]);
+    }
+  }
+  return classes.size();
+}
+
+template <class Function>
+void RunInParallel(size_t threads_count, Function function) {
+  std::vector<std::thread> threads;
+  for (size_t thread_index = 1; thread_index < threads_count; ++thread_index) {
+    threads.emplace_back(function, thread_index);
+  }
+  function(0);
+  for (auto &thread: threads) {
+    thread.join();
+  }
+}
+
+struct HashedTriangle {
+  Triangle triangle;
+  uint64_t hash_value;
+};
+
+/*
+ * Параллельный точный подсчёт. Каждый поток нормализует свою часть
+ * входа и раскладывает треугольники по шардам по старшим битам хеша
+ * (ячейку в таблице выбирают младшие биты, так что они независимы).
+ * Затем каждый шард целиком обрабатывает один поток: одинаковые
+ * треугольники всегда в одном шарде, поэтому классы шардов не
+ * пересекаются и ответ — сумма их размеров без всякой синхронизации.
+ */
+size_t GetSimilarityClassesParallel(const std::vector<Triangle>& triangles,
+                                    size_t threads_count) {
+  int shard_bits = 0;
+  while ((size_t(1) << shard_bits) < threads_count * SHARDS_PER_THREAD) {
+    ++shard_bits;
+  }
+  size_t shards_count = size_t(1) << shard_bits;
+  std::vector<std::vector<std::vector<HashedTriangle>>> buffers(
+      threads_count, std::vector<std::vector<HashedTriangle>>(shards_count));
+  RunInParallel(threads_count, [&](size_t thread_index) {
+    size_t begin = triangles.size() * thread_index / threads_count;
+    size_t end = triangles.size() * (thread_index + 1) / threads_count;
+    auto &shard_buffers = buffers[thread_index];
+    for (auto &buffer: shard_buffers) {
+      buffer.reserve((end - begin) / shards_count * 9 / 8 + NORMALIZE_BATCH_SIZE);
+    }
+    Triangle normalized[NORMALIZE_BATCH_SIZE];
+    uint64_t hashes[NORMALIZE_BATCH_SIZE];
+    for (; begin < end; begin += NORMALIZE_BATCH_SIZE) {
+      size_t count = std::min(NORMALIZE_BATCH_SIZE, end - begin);
+      NormalizeTriangles(triangles.data() + begin, count, normalized, hashes);
+      for (size_t i = 0; i < count; ++i) {
+        shard_buffers[hashes[i] >> (64 - shard_bits)].push_back({normalized[i], hashes[i]});
+      }
+    }
+  });
+  std::vector<size_t> shard_classes(shards_count);
+  RunInParallel(threads_count, [&](size_t thread_index) {
+    for (size_t shard = thread_index; shard < shards_count; shard += threads_count) {
+      size_t shard_size = 0;
+      for (const auto &shard_buffers: buffers) {
+        shard_size += shard_buffers[shard].size();
+      }
+      TriangleHashSet classes(shard_size);
+      for (auto &shard_buffers: buffers) {
+        for (const auto &hashed: shard_buffers[shard]) {
+          classes.Insert(hashed.triangle, hashed.hash_value);
         }
+        std::vector<HashedTriangle>().swap(shard_buffers[shard]);
+      }
+      shard_classes[shard] = classes.size();
+    }
+  });
+  size_t number_of_classes = 0;
+  for (auto classes: shard_classes) {
+    number_of_classes += classes;
+  }
+  return number_of_classes;
+}
+
+/*
+ * HyperLogLog: 2^precision регистров по байту, регистр выбирают старшие
+ * биты хеша, в нём хранится максимальная позиция первой единицы среди
+ * остальных битов. Оценка — гармоническое среднее с поправкой на малые
+ * мощности (linear counting), относительная стандартная ошибка
+ * 1.04 / sqrt(2^precision).
+ */
+class HyperLogLog {
+ public:
+  explicit HyperLogLog(int precision):
+      precision_(precision),
+      registers_(size_t(1) << precision, 0)
+  {}
+
+  void Add(uint64_t hash_value) {
+    size_t index = hash_value >> (64 - precision_);
+    uint64_t rest = (hash_value << precision_) | (uint64_t(1) << (precision_ - 1));
+    auto rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    registers_[index] = std::max(registers_[index], rank);
+  }
+
+  double Estimate() const {
+    double registers_count = registers_.size();
+    double inverse_sum = 0;
+    size_t zero_registers = 0;
+    for (auto rank: registers_) {
+      inverse_sum += std::ldexp(1.0, -rank);
+      zero_registers += rank == 0;
+    }
+    double estimate = Alpha() * registers_count * registers_count / inverse_sum;
+    if (estimate <= 2.5 * registers_count && zero_registers != 0) {
+      estimate = registers_count * std::log(registers_count / zero_registers);
+    }
+    return estimate;
+  }
+
+  double RelativeError() const {
+    return 1.04 / std::sqrt(static_cast<double>(registers_.size()));
+  }
+
+ private:
+  int precision_;
+  std::vector<uint8_t> registers_;
+
+  /*
+   * Поправочный множитель оценки. Приближение 0.7213 / (1 + 1.079 / m)
+   * верно лишь начиная с m = 128, для меньшего числа регистров берутся
+   * табличные значения из статьи Flajolet et al.
+   */
+  double Alpha() const {
+    switch (precision_) {
+      case 4:
+        return 0.673;
+      case 5:
+        return 0.697;
+      case 6:
+        return 0.709;
+      default:
+        return 0.7213 / (1 + 1.079 / registers_.size());
+    }
+  }
+};
+
+/*
+ * Приближённый режим читает вход пачками и не хранит ни треугольники,
+ * ни классы: память — только регистры HyperLogLog.
+ */
+HyperLogLog EstimateSimilarityClasses(FastReader& reader, size_t size, int precision) {
+  HyperLogLog estimator(precision);
+  Triangle triangles[NORMALIZE_BATCH_SIZE];
+  Triangle normalized[NORMALIZE_BATCH_SIZE];
+  uint64_t hashes[NORMALIZE_BATCH_SIZE];
+  for (size_t begin = 0; begin < size; begin += NORMALIZE_BATCH_SIZE) {
+    size_t count = std::min(NORMALIZE_BATCH_SIZE, size - begin);
+    for (size_t i = 0; i < count; ++i) {
+      int a_segment = reader.ReadInteger();
+      int b_segment = reader.ReadInteger();
+      int c_segment = reader.ReadInteger();
+      triangles[i] = Triangle(a_segment, b_segment, c_segment);
+    }
+    NormalizeTriangles(triangles, count, normalized, hashes);
+    for (size_t i = 0; i < count; ++i) {
+      estimator.Add(hashes[i]);
+    }
+  }
+  return estimator;
+}
+
+/*
+ * Отсортированная серия различных треугольников во временном файле.
+ * Файл удаляется сразу после создания и живёт, пока открыт дескриптор.
+ * Серия сначала дописывается, затем один раз читается подряд; буфер
+ * выделяется только на время записи и чтения.
+ */
+class SpillRun {
+ public:
+  explicit SpillRun(const std::string& directory):
+      buffer_size_(0),
+      buffer_position_(0) {
+    std::string path = directory + "/triangles-XXXXXX";
+    descriptor_ = mkstemp(&path[0]);
+    if (descriptor_ < 0) {
+      throw std::runtime_error("Cannot create spill file in " + directory);
+    }
+    unlink(path.c_str());
+  }
+
+  SpillRun(const SpillRun&) = delete;
+  SpillRun& operator=(const SpillRun&) = delete;
+
+  ~SpillRun() {
+    close(descriptor_);
+  }
+
+  void Append(const Triangle& triangle) {
+    if (buffer_.empty()) {
+      buffer_.resize(SPILL_BUFFER_TRIANGLES);
+    }
+    if (buffer_size_ == buffer_.size()) {
+      Flush();
+    }
+    buffer_[buffer_size_++] = triangle;
+  }
+
+  void FinishWriting() {
+    Flush();
+    std::vector<Triangle>().swap(buffer_);
+    if (lseek(descriptor_, 0, SEEK_SET) != 0) {
+      throw std::runtime_error("Cannot rewind spill file");
+    }
+  }
+
+  bool ReadNext(Triangle& triangle) {
+    if (buffer_position_ == buffer_size_ && !Refill()) {
+      std::vector<Triangle>().swap(buffer_);
+      return false;
+    }
+    triangle = buffer_[buffer_position_++];
+    return true;
+  }
+
+ private:
+  int descriptor_;
+  std::vector<Triangle> buffer_;
+  size_t buffer_size_;
+  size_t buffer_position_;
+
+  void Flush() {
+    auto data = reinterpret_cast<const char*>(buffer_.data());
+    size_t bytes_left = buffer_size_ * sizeof(Triangle);
+    while (bytes_left > 0) {
+      auto bytes_written = write(descriptor_, data, bytes_left);
+      if (bytes_written < 0 && errno == EINTR) {
+        continue;
       }
-      if (!found) {
-        table[hash_value].push_back(normalized);
+      if (bytes_written <= 0) {
+        throw std::runtime_error("Cannot write spill file");
       }
+      data += bytes_written;
+      bytes_left -= bytes_written;
     }
+    buffer_size_ = 0;
   }
-  int number_of_classes = 0;
-  for (int i = 0; i < TABLESIZE; ++i) {
-    number_of_classes += table[i].size();
+
+  bool Refill() {
+    if (buffer_.empty()) {
+      buffer_.resize(SPILL_BUFFER_TRIANGLES);
+    }
+    auto data = reinterpret_cast<char*>(buffer_.data());
+    size_t bytes_read = 0;
+    size_t capacity = buffer_.size() * sizeof(Triangle);
+    while (bytes_read < capacity) {
+      auto result = read(descriptor_, data + bytes_read, capacity - bytes_read);
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result < 0) {
+        throw std::runtime_error("Cannot read spill file");
+      }
+      if (result == 0) {
+        break;
+      }
+      bytes_read += result;
+    }
+    buffer_size_ = bytes_read / sizeof(Triangle);
+    buffer_position_ = 0;
+    return buffer_size_ > 0;
   }
-  return number_of_classes;
+};
+
+/*
+ * Сливает серии и возвращает число различных треугольников в них;
+ * если задана output, различные треугольники дописываются в неё.
+ * Серии после слияния удаляются.
+ */
+size_t MergeSpillRuns(std::vector<std::unique_ptr<SpillRun>>& runs, SpillRun* output) {
+  typedef std::pair<Triangle, size_t> RunHead;
+  auto is_later = [](const RunHead& first, const RunHead& second) {
+    return second.first < first.first;
+  };
+  std::priority_queue<RunHead, std::vector<RunHead>, decltype(is_later)> heads(is_later);
+  for (size_t run_index = 0; run_index < runs.size(); ++run_index) {
+    Triangle triangle;
+    if (runs[run_index]->ReadNext(triangle)) {
+      heads.emplace(triangle, run_index);
+    }
+  }
+  size_t distinct = 0;
+  Triangle last;
+  while (!heads.empty()) {
+    auto head = heads.top();
+    heads.pop();
+    if (distinct == 0 || !(head.first == last)) {
+      ++distinct;
+      last = head.first;
+      if (output != nullptr) {
+        output->Append(last);
+      }
+    }
+    if (runs[head.second]->ReadNext(head.first)) {
+      heads.push(head);
+    }
+  }
+  runs.clear();
+  if (output != nullptr) {
+    output->FinishWriting();
+  }
+  return distinct;
 }
 
-int main() {
-  int size;
-  std::cin >> size;
-  auto triangles = ReadInput(size);
-  std::cout << GetSimilarityClasses(triangles) << '\n';
+/*
+ * Потоковый подсчёт с ограниченной памятью: вход читается пачками и
+ * сразу нормализуется, в памяти живёт только множество классов. Когда
+ * оно заполняется, классы сбрасываются на диск отсортированной серией,
+ * а в конце серии сливаются с подсчётом различных. В memory_budget
+ * входят и буферы серий: у каждой читаемой при слиянии серии и у
+ * записываемой свой буфер, поэтому число одновременно сливаемых серий
+ * ограничено четвертью бюджета (но не больше MAX_SPILL_RUNS), а таблице
+ * достаётся остальное. Набрав столько серий, мы заранее сливаем их в одну.
+ */
+size_t GetSimilarityClassesStreaming(FastReader& reader, size_t size, size_t memory_budget,
+                                     const std::string& spill_directory) {
+  constexpr size_t run_buffer_size = SPILL_BUFFER_TRIANGLES * sizeof(Triangle);
+  size_t merge_buffers_count = memory_budget / 4 / run_buffer_size;
+  size_t max_merged_runs = std::max<size_t>(
+      2, std::min(MAX_SPILL_RUNS, merge_buffers_count > 0 ? merge_buffers_count - 1 : 0));
+  size_t merge_buffers_size = (max_merged_runs + 1) * run_buffer_size;
+  size_t max_classes = TriangleHashSet::MaxSizeWithin(
+      memory_budget > merge_buffers_size ? memory_budget - merge_buffers_size : 0);
+  TriangleHashSet classes(std::min(size, max_classes));
+  std::vector<std::unique_ptr<SpillRun>> runs;
+  auto spill = [&]() {
+    if (runs.size() == max_merged_runs) {
+      auto merged = std::make_unique<SpillRun>(spill_directory);
+      MergeSpillRuns(runs, merged.get());
+      runs.push_back(std::move(merged));
+    }
+    auto run = std::make_unique<SpillRun>(spill_directory);
+    classes.DrainSorted([&](const Triangle& triangle) {
+      run->Append(triangle);
+    });
+    run->FinishWriting();
+    runs.push_back(std::move(run));
+  };
+  Triangle triangles[NORMALIZE_BATCH_SIZE];
+  Triangle normalized[NORMALIZE_BATCH_SIZE];
+  uint64_t hashes[NORMALIZE_BATCH_SIZE];
+  for (size_t begin = 0; begin < size; begin += NORMALIZE_BATCH_SIZE) {
+    size_t count = std::min(NORMALIZE_BATCH_SIZE, size - begin);
+    for (size_t i = 0; i < count; ++i) {
+      int a_segment = reader.ReadInteger();
+      int b_segment = reader.ReadInteger();
+      int c_segment = reader.ReadInteger();
+      triangles[i] = Triangle(a_segment, b_segment, c_segment);
+    }
+    NormalizeTriangles(triangles, count, normalized, hashes);
+    for (size_t i = 0; i < count; ++i) {
+      classes.Prefetch(hashes[i]);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      classes.Insert(normalized[i], hashes[i]);
+      if (classes.size() == max_classes) {
+        spill();
+      }
+    }
+  }
+  if (runs.empty()) {
+    return classes.size();
+  }
+  if (classes.size() > 0) {
+    spill();
+  }
+  classes = TriangleHashSet(0);
+  return MergeSpillRuns(runs, nullptr);
+}
+
+struct ProgramOptions {
+  bool benchmark = false;
+  bool approximate = false;
+  int hyper_log_log_precision = 14;
+  size_t threads_count = 1;
+  bool streaming = false;
+  size_t memory_budget_mb = DEFAULT_MEMORY_BUDGET_MB;
+  std::string spill_directory = "/tmp";
+  std::string input_path;
+};
+
+ProgramOptions ParseProgramOptions(int argc, char* argv[]) {
+  ProgramOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string option = argv[i];
+    if (option == "--bench") {
+      options.benchmark = true;
+    } else if (option == "--approximate") {
+      options.approximate = true;
+    } else if (option == "--hll-precision" && i + 1 < argc) {
+      options.hyper_log_log_precision = std::stoi(argv[++i]);
+      if (options.hyper_log_log_precision < MIN_HYPER_LOG_LOG_PRECISION ||
+          options.hyper_log_log_precision > MAX_HYPER_LOG_LOG_PRECISION) {
+        throw std::invalid_argument("HyperLogLog precision must be in [" +
+                                    std::to_string(MIN_HYPER_LOG_LOG_PRECISION) + ", " +
+                                    std::to_string(MAX_HYPER_LOG_LOG_PRECISION) + "]");
+      }
+    } else if (option == "--threads" && i + 1 < argc) {
+      options.threads_count = std::max(1ul, std::stoul(argv[++i]));
+    } else if (option == "--stream") {
+      options.streaming = true;
+    } else if (option == "--memory-budget" && i + 1 < argc) {
+      options.streaming = true;
+      options.memory_budget_mb = std::max(1ul, std::stoul(argv[++i]));
+    } else if (option == "--spill-dir" && i + 1 < argc) {
+      options.spill_directory = argv[++i];
+    } else if (option == "--input" && i + 1 < argc) {
+      options.input_path = argv[++i];
+    } else {
+      throw std::invalid_argument("Unknown option " + option);
+    }
+  }
+  return options;
+}
+
+std::vector<Triangle> GenerateTriangles(size_t count) {
+  std::mt19937 generator(2017);
+  std::uniform_int_distribution<int> segment_distribution(1, 1000000);
+  std::uniform_int_distribution<int> factor_distribution(1, 8);
+  std::vector<Triangle> triangles;
+  triangles.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    int factor = factor_distribution(generator);
+    int a_segment = segment_distribution(generator) / 8 * factor;
+    int b_segment = segment_distribution(generator) / 8 * factor;
+    int c_segment = segment_distribution(generator) / 8 * factor;
+    triangles.emplace_back(a_segment + factor, b_segment + factor, c_segment + factor);
+  }
+  return triangles;
+}
+
+/*
+ * Сравнивает нормализацию с хешированием: прежнюю (вектор, std::sort,
+ * алгоритм Евклида), скалярную новую и пакетную. Сумма хешей служит
+ * и защитой от выкидывания кода компилятором, и проверкой совпадения.
+ */
+void WriteBenchmark(FastWriter& writer) {
+  auto triangles = GenerateTriangles(BENCHMARK_TRIANGLES_COUNT);
+  auto measure = [&](const char* name, auto normalize_range) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t checksum = normalize_range();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    writer.WriteFormatted("%s: %.2f ns per triangle, checksum %llx\n", name,
+                          seconds * 1e9 / triangles.size(),
+                          static_cast<unsigned long long>(checksum));
+  };
+  measure("sort + euclid", [&]() {
+    uint64_t checksum = 0;
+    for (const auto &triangle: triangles) {
+      checksum += HashTriangle(NormalizeTriangleWithSort(triangle));
+    }
+    return checksum;
+  });
+  measure("network + stein", [&]() {
+    uint64_t checksum = 0;
+    for (const auto &triangle: triangles) {
+      checksum += HashTriangle(NormalizeTriangle(triangle));
+    }
+    return checksum;
+  });
+  measure("batched", [&]() {
+    uint64_t checksum = 0;
+    Triangle normalized[NORMALIZE_BATCH_SIZE];
+    uint64_t hashes[NORMALIZE_BATCH_SIZE];
+    for (size_t begin = 0; begin < triangles.size(); begin += NORMALIZE_BATCH_SIZE) {
+      size_t count = std::min(NORMALIZE_BATCH_SIZE, triangles.size() - begin);
+      NormalizeTriangles(triangles.data() + begin, count, normalized, hashes);
+      for (size_t i = 0; i < count; ++i) {
+        checksum += hashes[i];
+      }
+    }
+    return checksum;
+  });
+}
+
+int main(int argc, char* argv[]) {
+  auto options = ParseProgramOptions(argc, argv);
+  FastWriter writer;
+  if (options.benchmark) {
+    WriteBenchmark(writer);
+    return 0;
+  }
+  int descriptor = STDIN_FILENO;
+  if (!options.input_path.empty()) {
+    descriptor = open(options.input_path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      throw std::runtime_error("Cannot open " + options.input_path);
+    }
+  }
+  FastReader reader(descriptor);
+  auto size = reader.ReadInteger<size_t>();
+  if (options.streaming) {
+    writer.WriteInteger(GetSimilarityClassesStreaming(
+        reader, size, options.memory_budget_mb << 20, options.spill_directory));
+    writer.WriteChar('\n');
+    return 0;
+  }
+  if (options.approximate) {
+    auto estimator = EstimateSimilarityClasses(reader, size, options.hyper_log_log_precision);
+    double estimate = estimator.Estimate();
+    writer.WriteFormatted("%.0f +- %.0f\n", estimate, estimate * estimator.RelativeError());
+    return 0;
+  }
+  auto triangles = ReadInput(reader, size);
+  if (options.threads_count > 1) {
+    writer.WriteInteger(GetSimilarityClassesParallel(triangles, options.threads_count));
+  } else {
+    writer.WriteInteger(GetSimilarityClasses(triangles));
+  }
+  writer.WriteChar('\n');
   return 0;
 }